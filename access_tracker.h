@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_ACCESS_TRACKER_H
+#define FASTCOMPRESS_ACCESS_TRACKER_H
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace FastCompress {
+
+/**
+ * @brief storage class a page's hotness calls for, from uncompressed to written back
+ * */
+enum class Temperature {
+  Hot,//keep raw
+  Warm,//fast compressor
+  Cold,//strong compressor
+  Frozen,//write back to the backing device
+};
+
+/**
+ * @brief per-page hotness for tiering and eviction decisions, about two bytes per page.
+ *
+ * Age is an 8-bit per-page count of epochs (tick() calls) since the last access, saturating at
+ * 255. Frequency comes from a count-min sketch of 8-bit counters, 4 rows of about npages / 4
+ * each, with conservative update; every decay_period recorded accesses all counters are halved,
+ * so frequency estimates follow the recent access mix (TinyLFU aging).
+ *
+ * record() may run on several threads at once; concurrent increments and halving use relaxed
+ * atomics and can lose a count, which only adds to the sketch's own over-estimate noise.
+ * */
+class AccessTracker {
+ public:
+  struct Thresholds {
+    uint32_t hot_frequency = 8;//estimated recent accesses of a hot page
+    uint8_t cold_age = 10;//idle epochs before an infrequent page is cold
+    uint8_t frozen_age = 40;//idle epochs before a page is written back
+  };
+
+  /**
+   * @param decay_period recorded accesses between two halvings, 0 for 10 per page
+   * */
+  explicit AccessTracker(size_t npages, size_t decay_period = 0)
+      : age_(npages), sketch_(kRows * sketchWidth(npages)), width_mask_(sketchWidth(npages) - 1),
+        decay_period_(decay_period ? decay_period : std::max<size_t>(10 * npages, 1)) {
+    for(std::atomic<uint8_t>& age : age_) {
+      age.store(0, std::memory_order_relaxed);
+    }
+    for(std::atomic<uint8_t>& counter : sketch_) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+  }
+
+  AccessTracker(const AccessTracker&) = delete;
+
+  AccessTracker& operator=(const AccessTracker&) = delete;
+
+  void record(size_t page) {
+    age_[page].store(0, std::memory_order_relaxed);
+    //conservative update: raise only the counters at the current minimum
+    uint32_t estimate = frequency(page);
+    if(estimate < UINT8_MAX) {
+      for(size_t row = 0; row < kRows; row++) {
+        std::atomic<uint8_t>& counter = sketch_[slot(page, row)];
+        if(counter.load(std::memory_order_relaxed) == estimate) {
+          counter.store(estimate + 1, std::memory_order_relaxed);
+        }
+      }
+    }
+    if(recorded_.fetch_add(1, std::memory_order_relaxed) % decay_period_ == decay_period_ - 1) {
+      for(std::atomic<uint8_t>& counter : sketch_) {
+        counter.store(counter.load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  //estimated accesses since the last decays, never below the true count unless a decay halved it
+  uint32_t frequency(size_t page) const {
+    uint32_t estimate = UINT8_MAX;
+    for(size_t row = 0; row < kRows; row++) {
+      estimate = std::min<uint32_t>(estimate, sketch_[slot(page, row)].load(std::memory_order_relaxed));
+    }
+    return estimate;
+  }
+
+  uint8_t age(size_t page) const { return age_[page].load(std::memory_order_relaxed); }
+
+  //close an epoch: every page ages by one
+  void tick() {
+    for(std::atomic<uint8_t>& age : age_) {
+      uint8_t value = age.load(std::memory_order_relaxed);
+      if(value < UINT8_MAX) {
+        //a record() racing with this keeps its 0, compare-and-swap never overwrites it
+        age.compare_exchange_strong(value, value + 1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  Temperature classify(size_t page, const Thresholds& thresholds) const {
+    uint8_t idle = age(page);
+    if(idle >= thresholds.frozen_age) {
+      return Temperature::Frozen;
+    }
+    uint32_t recent = frequency(page);
+    if(recent >= thresholds.hot_frequency) {
+      return idle == 0 ? Temperature::Hot : Temperature::Warm;
+    }
+    return idle >= thresholds.cold_age ? Temperature::Cold : Temperature::Warm;
+  }
+
+  size_t pages() const { return age_.size(); }
+
+ private:
+  static constexpr size_t kRows = 4;
+
+  static size_t sketchWidth(size_t npages) {
+    size_t width = 64;
+    while(width * kRows < npages) {
+      width <<= 1;
+    }
+    return width;
+  }
+
+  size_t slot(size_t page, size_t row) const {
+    //multiply-shift hashing, one odd multiplier per row
+    static constexpr uint64_t kSeeds[kRows] = {0x9E3779B97F4A7C15ull, 0xC2B2AE3D27D4EB4Full,
+                                               0x165667B19E3779F9ull, 0xD6E8FEB86659FD93ull};
+    return row * (width_mask_ + 1) + (((page + 1) * kSeeds[row]) >> 32 & width_mask_);
+  }
+
+  std::vector<std::atomic<uint8_t>> age_;
+  std::vector<std::atomic<uint8_t>> sketch_;
+  size_t width_mask_;
+  size_t decay_period_;
+  std::atomic<size_t> recorded_{0};
+};
+
+}
+
+#endif //FASTCOMPRESS_ACCESS_TRACKER_H
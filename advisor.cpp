@@ -0,0 +1,144 @@
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "benchmark.h"
+#include "compress.h"
+
+namespace {
+
+//measured and modelled cost of one algorithm/level/block size configuration
+struct Candidate {
+  std::string algorithm;
+  int level = 0;//0 for the algorithms without levels
+  size_t block_pages = 1;
+  double ratio = 0;
+  double compress_us = 0;//per page
+  double decompress_us = 0;//per page
+  double cpu_share = 0;//of one core at the target page rate
+  double saved = 0;//fraction of the memory of every compressed page
+  double fault_latency_us = 0;//decompression of the block holding a faulting page
+  bool feasible = false;
+};
+
+//microseconds per page from a MiB/Second throughput
+double usPerPage(double throughput) {
+  return throughput > 0 ? 1e6 / (throughput * kMegaByte / kPageSize) : 0;
+}
+
+//algorithm name with its level, e.g. zstd:3
+std::string label(const std::string& algorithm, int level) {
+  return level ? algorithm + ":" + std::to_string(level) : algorithm;
+}
+
+/**
+ * @brief least-squares fit of time per block = overhead + per_page * block_pages over the
+ * measured block sizes of one algorithm and level
+ * */
+void fitBlockCost(const std::vector<Candidate>& runs, bool decompress, double& overhead, double& per_page) {
+  double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for(const Candidate& run : runs) {
+    double x = run.block_pages;
+    double y = (decompress ? run.decompress_us : run.compress_us) * run.block_pages;
+    n++;
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    sxy += x * y;
+  }
+  double denominator = n * sxx - sx * sx;
+  per_page = denominator != 0 ? (n * sxy - sx * sy) / denominator : sy / sx;
+  overhead = denominator != 0 ? (sy - per_page * sx) / n : 0;
+}
+
+}
+
+int runAdvisor(const AdvisorConfig& advisor) {
+  std::cout << "[INFO]: advisor objective: maximize memory saved, cpu <= " << advisor.cpu_budget
+            << "% of one core at " << advisor.pages_per_second << " pages/Second, "
+            << advisor.fault_ratio << " faults per compressed page";
+  if(advisor.max_latency_us > 0) {
+    std::cout << ", fault latency <= " << advisor.max_latency_us << " us";
+  }
+  std::cout << std::endl;
+
+  std::vector<std::pair<std::string, int>> configurations;
+  for(const std::string& algorithm : advisor.algorithms) {
+    if(FastCompress::hasCompressionLevel(algorithm) && !advisor.levels.empty()) {
+      for(int level : advisor.levels) {
+        configurations.emplace_back(algorithm, level);
+      }
+    } else {
+      configurations.emplace_back(algorithm, 0);
+    }
+  }
+
+  std::vector<Candidate> candidates;
+  for(const auto& [algorithm, level] : configurations) {
+    std::vector<Candidate> runs;
+    for(size_t block_pages : advisor.block_pages) {
+      BenchConfig config;
+      config.path = advisor.path;
+      config.block_pages = block_pages;
+      config.niteration = advisor.niteration;
+      config.algorithm = algorithm;
+      config.level = level;
+      config.sample_bytes = advisor.sample_bytes;
+      config.verbose = false;
+      Candidate candidate;
+      candidate.algorithm = algorithm;
+      candidate.level = level;
+      candidate.block_pages = block_pages;
+      //average over repeats, the sample is small enough for noise to matter
+      for(size_t r = 0; r < advisor.repeat; r++) {
+        BenchResult result = runBenchmark(config);
+        candidate.ratio += result.compression_ratio / advisor.repeat;
+        candidate.compress_us += usPerPage(result.compression_throughput) / advisor.repeat;
+        candidate.decompress_us += usPerPage(result.decompression_throughput) / advisor.repeat;
+      }
+      //every page is compressed once and decompressed fault_ratio times
+      double us_per_page = candidate.compress_us + advisor.fault_ratio * candidate.decompress_us;
+      candidate.cpu_share = 100.0 * advisor.pages_per_second * us_per_page / 1e6;
+      candidate.saved = candidate.ratio > 0 ? 1 - 1 / candidate.ratio : 0;
+      candidate.fault_latency_us = candidate.decompress_us * block_pages;
+      candidate.feasible = candidate.cpu_share <= advisor.cpu_budget
+                           && (advisor.max_latency_us <= 0 || candidate.fault_latency_us <= advisor.max_latency_us);
+      runs.push_back(candidate);
+    }
+    if(runs.size() >= 2) {
+      double overhead, per_page;
+      fitBlockCost(runs, false, overhead, per_page);
+      printf("[INFO]: %-8s compress cost %.2f us/block + %.2f us/page", label(algorithm, level).c_str(), overhead,
+             per_page);
+      fitBlockCost(runs, true, overhead, per_page);
+      printf(", decompress cost %.2f us/block + %.2f us/page\n", overhead, per_page);
+    }
+    candidates.insert(candidates.end(), runs.begin(), runs.end());
+  }
+
+  printf("%-8s %6s %8s %12s %12s %10s %10s %14s\n", "algo", "block", "ratio", "comp us/pg", "decomp us/pg",
+         "cpu %", "saved %", "fault lat us");
+  const Candidate* best = nullptr;
+  for(const Candidate& candidate : candidates) {
+    printf("%-8s %6zu %8.3f %12.3f %12.3f %10.2f %10.2f %14.2f%s\n",
+           label(candidate.algorithm, candidate.level).c_str(),
+           candidate.block_pages, candidate.ratio, candidate.compress_us, candidate.decompress_us,
+           candidate.cpu_share, 100 * candidate.saved, candidate.fault_latency_us,
+           candidate.feasible ? "" : "  (over budget)");
+    //ties on memory saved go to the cheaper configuration
+    if(candidate.feasible && (best == nullptr || candidate.saved > best->saved
+                              || (candidate.saved == best->saved && candidate.cpu_share < best->cpu_share))) {
+      best = &candidate;
+    }
+  }
+
+  if(best == nullptr) {
+    std::cout << "[ERROR]: no configuration fits the budget" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "[INFO]: recommended " << label(best->algorithm, best->level) << ", block size " << best->block_pages
+            << " pages: saves " << 100 * best->saved << "% of compressed memory at " << best->cpu_share
+            << "% of one core" << std::endl;
+  return 0;
+}
@@ -0,0 +1,166 @@
+#include <algorithm>
+#include <atomic>
+#include <coroutine>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <latch>
+#include <string>
+#include <thread>
+#include <vector>
+#include "async_compress.h"
+#include "uring_store.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+static constexpr size_t kPageSize = 4096;
+static constexpr size_t kMegaByte = 0x01 << 20;
+
+struct AsyncOptions {
+  std::string path;
+  std::string algorithm = "lz4";
+  size_t threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t inflight = 64;//page operations issued at once
+  size_t limit_bytes = 64 * kMegaByte;
+  std::string backing = (std::filesystem::temp_directory_path() / "fastcompress-backing").string();
+};
+
+/**
+ * @brief fire-and-forget coroutine, runs eagerly and frees its frame when it finishes
+ * */
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+//compress every inflight-th page starting at first and write it back to its slot
+Detached writeOut(CompressExecutor& executor, UringBackingStore& store, const char* origin, size_t first,
+                  size_t npages, size_t stride, std::vector<size_t>& lengths, std::atomic<size_t>& errors,
+                  std::latch& finished) {
+  std::vector<char> compressed(store.slotSize());
+  for(size_t pid = first; pid < npages; pid += stride) {
+    size_t len = co_await compressAsync(executor, compressed.data(), compressed.size(), origin + pid * kPageSize, kPageSize);
+    int res = co_await writeBackAsync(store, pid, compressed.data(), len);
+    errors += res != (int) len;
+    lengths[pid] = len;
+  }
+  finished.count_down();
+}
+
+//read every inflight-th page back from its slot, decompress and check it
+Detached readIn(CompressExecutor& executor, UringBackingStore& store, const char* origin, size_t first,
+                size_t npages, size_t stride, const std::vector<size_t>& lengths, std::atomic<size_t>& errors,
+                std::latch& finished) {
+  std::vector<char> compressed(store.slotSize());
+  std::vector<char> page(kPageSize);
+  for(size_t pid = first; pid < npages; pid += stride) {
+    int res = co_await readBackAsync(store, pid, compressed.data(), lengths[pid]);
+    size_t len = co_await decompressAsync(executor, page.data(), kPageSize, compressed.data(), lengths[pid]);
+    errors += res != (int) lengths[pid] || len != kPageSize || memcmp(page.data(), origin + pid * kPageSize, kPageSize) != 0;
+  }
+  finished.count_down();
+}
+
+int main(int argc, char* argv[]) {
+  AsyncOptions options;
+  for(int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if(arg.rfind("--algorithm=", 0) == 0) {
+      options.algorithm = arg.substr(strlen("--algorithm="));
+    } else if(arg.rfind("--threads=", 0) == 0) {
+      options.threads = std::stoul(arg.substr(strlen("--threads=")));
+    } else if(arg.rfind("--inflight=", 0) == 0) {
+      options.inflight = std::max<size_t>(std::stoul(arg.substr(strlen("--inflight="))), 1);
+    } else if(arg.rfind("--limit-mb=", 0) == 0) {
+      options.limit_bytes = std::stoul(arg.substr(strlen("--limit-mb="))) * kMegaByte;
+    } else if(arg.rfind("--backing=", 0) == 0) {
+      options.backing = arg.substr(strlen("--backing="));
+    } else if(arg.rfind("--", 0) == 0 || !options.path.empty()) {
+      options.path.clear();
+      break;
+    } else {
+      options.path = arg;
+    }
+  }
+  if(options.path.empty()) {
+    std::cerr << "[USAGE]: file path [--algorithm=lz4] [--threads=n] [--inflight=n] [--limit-mb=n]"
+                 " [--backing=file]" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  std::ifstream fin(options.path, std::ios::binary);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << options.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t size = std::min(std::filesystem::file_size(options.path), options.limit_bytes);
+  size_t npages = size / kPageSize;
+  size = npages * kPageSize;
+  char* origin = (char*) aligned_alloc(kPageSize, std::max(size, kPageSize));
+  fin.read(origin, size);
+
+  //declared before the executor and the store: the last count_down may still be returning on
+  //their threads when wait() wakes up
+  size_t stride = std::min(options.inflight, std::max<size_t>(npages, 1));
+  std::latch write_finished(stride);
+  std::latch read_finished(stride);
+  CompressExecutor executor(options.algorithm, options.threads);
+  std::cout << "[INFO]: " << options.path << ", " << npages << " pages, " << options.algorithm << ", "
+            << executor.threads() << " executor threads, " << options.inflight << " operations in flight" << std::endl;
+
+  //blocking api: every page is handed to the pool and the caller waits for it
+  std::vector<char> compressed(2 * kPageSize);
+  Timer timer;
+  timer.start();
+  for(size_t pid = 0; pid < npages; pid++) {
+    std::promise<size_t> result;
+    executor.compress(compressed.data(), compressed.size(), origin + pid * kPageSize, kPageSize,
+                      [&](size_t len) { result.set_value(len); });
+    result.get_future().get();
+  }
+  double handoff_seconds = timer.duration_ns() / 1e9;
+  std::cout << "[INFO]: blocking handoff compress " << double(size) / kMegaByte / handoff_seconds << " MiB/s" << std::endl;
+
+  std::vector<size_t> lengths(npages);
+  std::atomic<size_t> errors{0};
+  try {
+    UringBackingStore store(options.backing, 2 * kPageSize, stride);
+    timer.start();
+    for(size_t c = 0; c < stride; c++) {
+      writeOut(executor, store, origin, c, npages, stride, lengths, errors, write_finished);
+    }
+    write_finished.wait();
+    double write_seconds = timer.duration_ns() / 1e9;
+    size_t stored = 0;
+    for(size_t len : lengths) {
+      stored += len;
+    }
+    timer.start();
+    for(size_t c = 0; c < stride; c++) {
+      readIn(executor, store, origin, c, npages, stride, lengths, errors, read_finished);
+    }
+    read_finished.wait();
+    double read_seconds = timer.duration_ns() / 1e9;
+    std::cout << "[INFO]: coroutine compress + io_uring write back " << double(size) / kMegaByte / write_seconds
+              << " MiB/s, ratio " << double(size) / std::max<size_t>(stored, 1) << std::endl;
+    std::cout << "[INFO]: coroutine io_uring read + decompress " << double(size) / kMegaByte / read_seconds << " MiB/s" << std::endl;
+  } catch(const std::exception& e) {
+    std::cerr << "[ERROR]: backing store " << options.backing << ": " << e.what() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  free(origin);
+  if(errors) {
+    std::cout << "[ERROR]: " << errors << " pages failed the round trip" << std::endl;
+    return EXIT_FAILURE;
+  }
+  return 0;
+}
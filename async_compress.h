@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_ASYNC_COMPRESS_H
+#define FASTCOMPRESS_ASYNC_COMPRESS_H
+
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "compress.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#define FASTCOMPRESS_COROUTINES 1
+#endif
+
+namespace FastCompress {
+
+/**
+ * @brief fixed pool of compression threads, each owning its own compressor instance; compressors
+ * keep all their state (contexts, lzo work memory) per instance, so the threads share nothing.
+ *
+ * compress()/decompress() queue the operation and return at once; done(size) runs on the pool
+ * thread that performed it, so callers issue many page operations without a thread each. The
+ * caller keeps src and dst alive until done runs.
+ * */
+class CompressExecutor {
+ public:
+  using Done = std::function<void(size_t)>;
+
+  CompressExecutor(const std::string& algorithm, size_t nthread, bool same_fill = true) {
+    for(size_t t = 0; t < std::max<size_t>(nthread, 1); t++) {
+      threads_.emplace_back([this, compressor = std::shared_ptr<LosslessCompressor>(
+                                       createCompressor(algorithm, same_fill))]() { run(*compressor); });
+    }
+  }
+
+  ~CompressExecutor() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    for(std::thread& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  CompressExecutor(const CompressExecutor&) = delete;
+
+  CompressExecutor& operator=(const CompressExecutor&) = delete;
+
+  void compress(void* dst, size_t dst_len, const void* src, size_t src_len, Done done) {
+    submit([=, done = std::move(done)](LosslessCompressor& compressor) {
+      done(compressor.compress(dst, dst_len, const_cast<void*>(src), src_len));
+    });
+  }
+
+  void decompress(void* dst, size_t dst_len, const void* src, size_t src_len, Done done) {
+    submit([=, done = std::move(done)](LosslessCompressor& compressor) {
+      done(compressor.decompress(dst, dst_len, const_cast<void*>(src), src_len));
+    });
+  }
+
+  size_t threads() const { return threads_.size(); }
+
+ private:
+  using Job = std::function<void(LosslessCompressor&)>;
+
+  void submit(Job job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    cv_.notify_one();
+  }
+
+  void run(LosslessCompressor& compressor) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while(true) {
+      cv_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+      if(jobs_.empty()) {
+        return;//stopping, and every queued job has run
+      }
+      Job job = std::move(jobs_.front());
+      jobs_.pop_front();
+      lock.unlock();
+      job(compressor);
+      lock.lock();
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Job> jobs_;
+  bool stop_ = false;
+  std::vector<std::thread> threads_;
+};
+
+#ifdef FASTCOMPRESS_COROUTINES
+
+/**
+ * @brief awaitable over a callback-style operation: start(done) launches it, the awaiting
+ * coroutine resumes on whichever thread calls done, with the result as the co_await value
+ * */
+template<typename Result>
+class CallbackAwaitable {
+ public:
+  using Start = std::function<void(std::function<void(Result)>)>;
+
+  explicit CallbackAwaitable(Start start) : start_(std::move(start)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  void await_suspend(std::coroutine_handle<> handle) {
+    //done may resume the coroutine, and free this awaitable, before start returns
+    Start start = std::move(start_);
+    start([this, handle](Result result) {
+      result_ = result;
+      handle.resume();
+    });
+  }
+
+  Result await_resume() const noexcept { return result_; }
+
+ private:
+  Start start_;
+  Result result_{};
+};
+
+//co_await compressAsync(...) yields the compressed size, resuming on an executor thread
+inline CallbackAwaitable<size_t> compressAsync(CompressExecutor& executor, void* dst, size_t dst_len,
+                                               const void* src, size_t src_len) {
+  return CallbackAwaitable<size_t>([=, &executor](CompressExecutor::Done done) {
+    executor.compress(dst, dst_len, src, src_len, std::move(done));
+  });
+}
+
+//co_await decompressAsync(...) yields the decompressed size, resuming on an executor thread
+inline CallbackAwaitable<size_t> decompressAsync(CompressExecutor& executor, void* dst, size_t dst_len,
+                                                 const void* src, size_t src_len) {
+  return CallbackAwaitable<size_t>([=, &executor](CompressExecutor::Done done) {
+    executor.decompress(dst, dst_len, src, src_len, std::move(done));
+  });
+}
+
+#endif
+
+}
+
+#endif //FASTCOMPRESS_ASYNC_COMPRESS_H
@@ -0,0 +1,587 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <random>
+#include <memory>
+#include "compress.h"
+#include "lz4_decode.h"
+#include "checksum.h"
+#include "page_scan.h"
+#include "benchmark.h"
+#include "energy.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+ShuffleGranularity parseShuffleGranularity(const std::string& name) {
+  if(name == "page") {
+    return ShuffleGranularity::Page;
+  }
+  if(name == "block") {
+    return ShuffleGranularity::Block;
+  }
+  if(name == "region") {
+    return ShuffleGranularity::Region;
+  }
+  if(name == "local") {
+    return ShuffleGranularity::Local;
+  }
+  std::cerr << "[ERROR]: unknown shuffle granularity " << name << " (page, block, region, local)" << std::endl;
+  exit(EXIT_FAILURE);
+}
+
+BlockLayout parseBlockLayout(const std::string& name) {
+  if(name == "slots") {
+    return BlockLayout::Slots;
+  }
+  if(name == "packed") {
+    return BlockLayout::Packed;
+  }
+  if(name == "both") {
+    return BlockLayout::Both;
+  }
+  std::cerr << "[ERROR]: unknown block layout " << name << " (slots, packed, both)" << std::endl;
+  exit(EXIT_FAILURE);
+}
+
+//permute consecutive units of unit pages, the last unit may be shorter
+static void permuteUnits(std::vector<size_t>& order, size_t unit, std::mt19937_64& generator) {
+  size_t nunit = (order.size() + unit - 1) / unit;
+  std::vector<size_t> units(nunit);
+  for(size_t u = 0; u < nunit; u++) {
+    units[u] = u;
+  }
+  std::shuffle(units.begin(), units.end(), generator);
+  std::vector<size_t> permuted;
+  permuted.reserve(order.size());
+  for(size_t u : units) {
+    for(size_t p = u * unit; p < std::min((u + 1) * unit, order.size()); p++) {
+      permuted.push_back(order[p]);
+    }
+  }
+  order.swap(permuted);
+}
+
+std::vector<size_t> pageOrder(size_t npages, bool shuffle, ShuffleGranularity granularity,
+                              size_t block_pages, size_t window, uint64_t seed) {
+  std::vector<size_t> order(npages);
+  for(size_t i = 0; i < npages; i++) {
+    order[i] = i;
+  }
+  if(!shuffle) {
+    return order;
+  }
+  std::mt19937_64 generator(seed);
+  //regions and windows are whole blocks, so only the page granularity breaks blocks apart
+  size_t window_pages = std::max<size_t>(1, (window + block_pages - 1) / block_pages) * block_pages;
+  switch(granularity) {
+    case ShuffleGranularity::Page:
+      std::shuffle(order.begin(), order.end(), generator);
+      break;
+    case ShuffleGranularity::Block:
+      permuteUnits(order, block_pages, generator);
+      break;
+    case ShuffleGranularity::Region:
+      permuteUnits(order, window_pages, generator);
+      break;
+    case ShuffleGranularity::Local:
+      for(size_t begin = 0; begin < npages; begin += window_pages) {
+        std::shuffle(order.begin() + begin, order.begin() + std::min(begin + window_pages, npages), generator);
+      }
+      break;
+  }
+  return order;
+}
+
+/**
+ * @brief lz4 whose batches go through the in-tree lock-step decoder once interleaving is on,
+ * built by the benchmark only so that the experiment stays out of the library
+ * */
+class InterleavedLZ4 : public LZ4 {
+ public:
+  void decompressBatch(void* const* dst, size_t dst_len, void* const* src, const size_t* src_len,
+                       size_t* decompressed, size_t n) override {
+    if(!interleaved_ || has_dict_) {
+      LZ4::decompressBatch(dst, dst_len, src, src_len, decompressed, n);
+      return;
+    }
+    for(size_t first = 0; first < n; first += kMaxInterleave) {
+      size_t group = std::min(kMaxInterleave, n - first);
+      int result[kMaxInterleave];
+      lz4DecodeInterleaved(src + first, src_len + first, dst + first, dst_len, result, group);
+      for(size_t i = 0; i < group; i++) {
+        if(result[i] < 0) {
+          std::cout << "[ERROR]: LZ4 decompression error!" << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        decompressed[first + i] = result[i];
+      }
+    }
+  }
+
+  bool setDictionary(const void* dict, size_t dict_len) override {
+    has_dict_ = dict_len > 0;
+    return LZ4::setDictionary(dict, dict_len);
+  }
+
+  bool setInterleaved(bool interleaved) override {
+    interleaved_ = interleaved;
+    return true;
+  }
+
+ private:
+  bool interleaved_ = false;
+  bool has_dict_ = false;
+};
+
+/**
+ * @brief per-page loops of a run; the common page sizes get instantiations whose stride and
+ * copy length are compile-time constants, PageSize 0 takes the page size at runtime
+ * */
+template<size_t PageSize>
+struct PageLoops {
+  static size_t bytes(size_t page_size) { return PageSize ? PageSize : page_size; }
+
+  static void classify(const char* base, size_t npages, size_t page_size, size_t& zero, size_t& same_filled) {
+    const size_t len = bytes(page_size);
+    for(size_t pid = 0; pid < npages; pid++) {
+      uint64_t pattern;
+      PageClass page_class = classifyPage(base + pid * len, len, &pattern);
+      zero += page_class == PageClass::Zero;
+      same_filled += page_class == PageClass::SameFilled;
+    }
+  }
+
+  static void checksum(ChecksumType type, const char* base, size_t npages, size_t page_size, uint64_t* sums) {
+    const size_t len = bytes(page_size);
+    for(size_t pid = 0; pid < npages; pid++) {
+      sums[pid] = pageChecksum(type, base + pid * len, len);
+    }
+  }
+
+  //pages whose checksum differs from sums
+  static size_t mismatches(ChecksumType type, const char* base, size_t npages, size_t page_size,
+                           const uint64_t* sums) {
+    const size_t len = bytes(page_size);
+    size_t mismatched = 0;
+    for(size_t pid = 0; pid < npages; pid++) {
+      mismatched += pageChecksum(type, base + pid * len, len) != sums[pid];
+    }
+    return mismatched;
+  }
+
+  //xor of every page checksum, the checksum-only pass
+  static uint64_t fold(ChecksumType type, const char* base, size_t npages, size_t page_size) {
+    const size_t len = bytes(page_size);
+    uint64_t sink = 0;
+    for(size_t pid = 0; pid < npages; pid++) {
+      sink ^= pageChecksum(type, base + pid * len, len);
+    }
+    return sink;
+  }
+
+  //copy pages[0..npages) of frames into the consecutive pages of block
+  static void gather(char* block, const char* frames, const size_t* pages, size_t npages, size_t page_size) {
+    const size_t len = bytes(page_size);
+    for(size_t pid = 0; pid < npages; pid++) {
+      memcpy(block + pid * len, frames + pages[pid] * len, len);
+    }
+  }
+
+  static void scatter(char* frames, const char* block, const size_t* pages, size_t npages, size_t page_size) {
+    const size_t len = bytes(page_size);
+    for(size_t pid = 0; pid < npages; pid++) {
+      memcpy(frames + pages[pid] * len, block + pid * len, len);
+    }
+  }
+};
+
+struct PageLoopTable {
+  decltype(&PageLoops<0>::classify) classify;
+  decltype(&PageLoops<0>::checksum) checksum;
+  decltype(&PageLoops<0>::mismatches) mismatches;
+  decltype(&PageLoops<0>::fold) fold;
+  decltype(&PageLoops<0>::gather) gather;
+  decltype(&PageLoops<0>::scatter) scatter;
+};
+
+template<size_t PageSize>
+static PageLoopTable pageLoopTable() {
+  return {PageLoops<PageSize>::classify, PageLoops<PageSize>::checksum, PageLoops<PageSize>::mismatches,
+          PageLoops<PageSize>::fold, PageLoops<PageSize>::gather, PageLoops<PageSize>::scatter};
+}
+
+//4, 16 and 64 KiB pages (x86, arm64 and power kernels) run the fixed-size loops
+static PageLoopTable selectPageLoops(size_t page_size) {
+  switch(page_size) {
+    case 4096:
+      return pageLoopTable<4096>();
+    case 16384:
+      return pageLoopTable<16384>();
+    case 65536:
+      return pageLoopTable<65536>();
+    default:
+      return pageLoopTable<0>();
+  }
+}
+
+BenchResult runBenchmark(const BenchConfig& config) {
+  BenchResult result;
+  //[INFO] lines go to a stream without buffer when the run is not verbose
+  std::ostream quiet(nullptr);
+  std::ostream& log = config.verbose ? std::cout : quiet;
+  size_t page_size = config.page_size;
+  if(page_size < kPageSize || (page_size & (page_size - 1)) != 0) {
+    std::cerr << "[ERROR]: page size " << page_size << " is not a power of two from " << kPageSize << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  if(config.interleave == 0) {
+    std::cerr << "[ERROR]: interleave must be at least 1 block" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t block_size = config.block_pages * page_size;
+  const PageLoopTable loops = selectPageLoops(page_size);
+
+  if(page_size != kPageSize) {
+    log << "[INFO]: page size " << page_size << std::endl;
+  }
+  log << "[INFO]: block size " << config.block_pages << " pages, "
+      << "number of iterations " << config.niteration << std::endl;
+  if(config.level) {
+    log << "[INFO]: " << config.algorithm << " compression level " << config.level << std::endl;
+  }
+  size_t size;
+  void* origin;
+  if(config.pid) {
+    origin = captureProcess(config.pid, config.regions, config.sample_bytes, size);
+    size = size / block_size * block_size;
+  } else {
+    std::ifstream fin(config.path);
+    if(!fin.good()) {
+      std::cerr << "[ERROR]: can't open " << config.path << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    size = std::filesystem::file_size(config.path);
+    if(config.sample_bytes) {
+      size = std::min(size, config.sample_bytes);
+    }
+    size = size / block_size * block_size;
+    origin = aligned_alloc(page_size, size);
+    fin.read((char*) origin, size);
+  }
+  log << "[INFO]: file size " << size << ", number of blocks " << size / block_size << std::endl;
+  result.file_size = size;
+  result.nblocks = size / block_size;
+  log << "[INFO]: kernels crc32c " << selectKernel(crc32cKernels()).name
+      << ", xxh3 " << selectKernel(xxh3Kernels()).name
+      << ", rle " << selectKernel(rleEncodeKernels()).name
+      << ", page classify " << selectKernel(classifyKernels()).name
+      << ", page fill " << selectKernel(fillKernels()).name << std::endl;
+  size_t zero_pages = 0;
+  size_t same_filled_pages = 0;
+  loops.classify((char*) origin, size / page_size, page_size, zero_pages, same_filled_pages);
+  log << "[INFO]: zero pages " << zero_pages << ", same-filled pages " << same_filled_pages << std::endl;
+
+  //the shuffle only permutes this index, pages stay where they were loaded
+  std::vector<size_t> order = pageOrder(size / page_size, config.page_shuffle, config.shuffle,
+                                        config.block_pages, config.shuffle_window, std::random_device{}());
+
+  //use factory function to choose commpressor based on input
+  std::unique_ptr<LosslessCompressor> compressor;
+  if(config.interleave > 1 && config.algorithm == "lz4" && config.level == 0) {
+    compressor = std::make_unique<InterleavedLZ4>();
+    if(config.same_fill) {
+      compressor = std::make_unique<SameFillFilter>(std::move(compressor));
+    }
+  } else {
+    compressor = createCompressor(config.algorithm, config.same_fill, config.level);
+  }
+  if(config.interleave > 1) {
+    log << "[INFO]: decompression in batches of " << config.interleave << " blocks, ";
+    if(compressor->setInterleaved(true)) {
+      size_t streams = config.algorithm == "lz4" ? kMaxInterleave : kMaxRleInterleave;
+      log << std::min(config.interleave, streams) << " streams interleaved" << std::endl;
+    } else {
+      log << "decoded one at a time, " << config.algorithm << " has no interleaved decoder" << std::endl;
+    }
+  }
+
+  //verify mode keeps a pristine copy, decompression overwrites origin
+  void* pristine = nullptr;
+  if(config.verify) {
+    pristine = aligned_alloc(page_size, size);
+    memcpy(pristine, origin, size);
+  }
+
+  size_t comp_block_size = block_size * 2;
+  void* compressed = aligned_alloc(page_size, comp_block_size * size / block_size);
+  size_t* compressed_size = (size_t*) calloc(size / block_size, sizeof(size_t));
+  //packed layout appends the blocks to the arena and remembers where each one starts
+  bool packed = config.layout != BlockLayout::Slots;
+  size_t* block_offset = (size_t*) calloc(size / block_size, sizeof(size_t));
+  size_t arena_used = 0;
+  size_t nblock = size / block_size;
+  size_t npage_per_block = config.block_pages;
+  size_t total_compressed = 0;
+  //per-page checksums of the uncompressed content, kept alongside compressed_size
+  uint64_t* page_checksum = config.checksum != ChecksumType::None ?
+                            (uint64_t*) calloc(size / page_size, sizeof(uint64_t)) : nullptr;
+  //contiguous blocks are compressed and decompressed in place; a block whose pages are not
+  //consecutive in memory is gathered into the staging area before any timing, and its pages are
+  //scattered back after the last timed pass, so neither copy is measured as (de)compression
+  std::vector<char*> block_base(nblock);
+  std::vector<size_t> scattered;
+  for(size_t bid = 0; bid < nblock; bid++) {
+    const size_t* pages = order.data() + bid * npage_per_block;
+    bool contiguous = true;
+    for(size_t pid = 1; pid < npage_per_block && contiguous; pid++) {
+      contiguous = pages[pid] == pages[0] + pid;
+    }
+    block_base[bid] = contiguous ? (char*) origin + pages[0] * page_size : nullptr;
+    if(!contiguous) {
+      scattered.push_back(bid);
+    }
+  }
+  char* staging = scattered.empty() ? nullptr : (char*) aligned_alloc(page_size, scattered.size() * block_size);
+  Timer gather_timer;
+  gather_timer.start();
+  for(size_t k = 0; k < scattered.size(); k++) {
+    size_t bid = scattered[k];
+    block_base[bid] = staging + k * block_size;
+    loops.gather(block_base[bid], (char*) origin, order.data() + bid * npage_per_block, npage_per_block, page_size);
+  }
+  long gather_drt = gather_timer.duration_us();
+  if(config.page_shuffle) {
+    log << "[INFO]: shuffled processing order, " << scattered.size() << " blocks gathered from scattered pages";
+    if(!scattered.empty()) {
+      log << " in " << gather_drt << " us, not part of the throughput";
+    }
+    log << std::endl;
+  }
+  std::unique_ptr<EnergyMeter> meter;
+  if(config.energy) {
+    meter = std::make_unique<EnergyMeter>();
+    if(!meter->available()) {
+      //an expected condition on many hosts (VMs, non-Intel), said once per process, runs go on without it
+      static bool reported = false;
+      if(!reported) {
+        std::cout << "[INFO]: no readable RAPL counter (powercap or /dev/cpu/0/msr), energy not measured" << std::endl;
+        reported = true;
+      }
+      meter.reset();
+    }
+  }
+  //energy counters cover the whole package, GiB of original data processed per pass
+  double gib = double(size * config.niteration) / (1024.0 * kMegaByte);
+  Timer timer;
+  if(meter) {
+    meter->start();
+  }
+  timer.start();
+
+  //double loop compression
+  for(size_t i = 0; i < config.niteration; i++) {//first loop: compression level
+    size_t tail = 0;//every iteration rewrites the arena from its start
+    for(size_t bid = 0; bid < nblock; bid++) {//second loop: compress each block
+      size_t offset = packed ? tail : bid * comp_block_size;
+      void* dst = (char*) compressed + offset;
+      char* src = block_base[bid];
+      size_t res = compressor->compress(dst, comp_block_size, src, block_size);
+      total_compressed += res;
+      compressed_size[bid] = res;
+      block_offset[bid] = offset;
+      tail += res;
+      if(page_checksum) {
+        loops.checksum(config.checksum, src, npage_per_block, page_size, page_checksum + bid * npage_per_block);
+      }
+    }
+    arena_used = tail;
+  }
+  long drt = timer.duration_us();
+  if(meter) {
+    result.compression_energy = meter->joules() / gib;
+  }
+
+  double tpt = double(size * config.niteration) / kMegaByte / drt * 1000000ul;
+  double ratio = double(size * config.niteration) / total_compressed;
+  result.compression_throughput = tpt;
+  result.compression_ratio = ratio;
+  log << "[INFO]: compression throughput " << tpt << " MiB/Second" << std::endl;
+  log << "[INFO]: compression ratio (original size / compressed size) " << ratio
+      << ", compressed size / original size " << 1 / ratio << std::endl;
+  if(packed) {
+    log << "[INFO]: packed arena " << double(arena_used) / kMegaByte << " MiB, offset table "
+        << double(nblock * sizeof(size_t)) / 1024 << " KiB, slots would take "
+        << double(nblock * comp_block_size) / kMegaByte << " MiB" << std::endl;
+  }
+  if(auto* filter = dynamic_cast<SameFillFilter*>(compressor.get())) {
+    log << "[INFO]: same-fill filter, zero blocks " << filter->zeroBlocks() / config.niteration
+        << ", same-filled blocks " << filter->sameFilledBlocks() / config.niteration << std::endl;
+  }
+
+  if(meter) {
+    log << "[INFO]: compression energy " << result.compression_energy << " Joules/GiB ("
+        << meter->source() << ")" << std::endl;
+    meter->start();
+  }
+  timer.start();
+
+  //double loop decompression
+  size_t short_blocks = 0;
+  size_t corrupted_pages = 0;
+  auto finishBlock = [&](size_t bid, char* dst, size_t res) {
+    if(res != block_size) {
+      short_blocks++;
+    }
+    if(page_checksum) {
+      corrupted_pages += loops.mismatches(config.checksum, dst, npage_per_block, page_size,
+                                          page_checksum + bid * npage_per_block);
+    }
+  };
+  auto decompressBlock = [&](size_t bid, void* src) {
+    finishBlock(bid, block_base[bid], compressor->decompress(block_base[bid], block_size, src, compressed_size[bid]));
+  };
+  std::vector<void*> batch_dst(config.interleave), batch_src(config.interleave);
+  std::vector<size_t> batch_len(config.interleave), batch_res(config.interleave), batch_bid(config.interleave);
+  auto decompressInterleaved = [&](size_t width) {
+    size_t n = 0;
+    auto flush = [&]() {
+      compressor->decompressBatch(batch_dst.data(), block_size, batch_src.data(), batch_len.data(), batch_res.data(), n);
+      for(size_t j = 0; j < n; j++) {
+        finishBlock(batch_bid[j], (char*) batch_dst[j], batch_res[j]);
+      }
+      n = 0;
+    };
+    for(size_t bid = 0; bid < nblock; bid++) {
+      batch_dst[n] = block_base[bid];
+      batch_src[n] = (char*) compressed + block_offset[bid];
+      batch_len[n] = compressed_size[bid];
+      batch_bid[n] = bid;
+      if(++n == width) {
+        flush();
+      }
+    }
+    if(n) {
+      flush();
+    }
+  };
+  for(size_t i = 0; i < config.niteration; i++) {
+    if(config.interleave > 1) {
+      decompressInterleaved(config.interleave);
+      continue;
+    }
+    for(size_t bid = 0; bid < nblock; bid++) {
+      decompressBlock(bid, (char*) compressed + block_offset[bid]);
+    }
+  }
+  drt = timer.duration_us();
+  if(meter) {
+    result.decompression_energy = meter->joules() / gib;
+  }
+  tpt = double(size * config.niteration) / kMegaByte / drt * 1000000ul;
+  result.decompression_throughput = tpt;
+  log << "[INFO]: decompression throughput " << tpt << " MiB/Second" << std::endl;
+  if(meter) {
+    log << "[INFO]: decompression energy " << result.decompression_energy << " Joules/GiB ("
+        << meter->source() << ")" << std::endl;
+  }
+
+  if(config.interleave > 1) {
+    //against the plain decompress call (the library decoder), what a batch has to beat
+    timer.start();
+    for(size_t i = 0; i < config.niteration; i++) {
+      for(size_t bid = 0; bid < nblock; bid++) {
+        decompressBlock(bid, (char*) compressed + block_offset[bid]);
+      }
+    }
+    long single_drt = timer.duration_us();
+    log << "[INFO]: " << config.interleave << "-way interleaved decompression, one decompress call per block "
+        << double(size * config.niteration) / kMegaByte / std::max(single_drt, 1l) * 1000000ul
+        << " MiB/Second, interleaved takes " << 100.0 * drt / std::max(single_drt, 1l) << "% of its time" << std::endl;
+  }
+
+  if(config.layout == BlockLayout::Both) {
+    //same blocks copied out to 2x slots, decompressed again to compare the footprints
+    void* slots = aligned_alloc(page_size, comp_block_size * nblock);
+    for(size_t bid = 0; bid < nblock; bid++) {
+      memcpy((char*) slots + bid * comp_block_size, (char*) compressed + block_offset[bid], compressed_size[bid]);
+    }
+    timer.start();
+    for(size_t i = 0; i < config.niteration; i++) {
+      for(size_t bid = 0; bid < nblock; bid++) {
+        decompressBlock(bid, (char*) slots + bid * comp_block_size);
+      }
+    }
+    long slots_drt = timer.duration_us();
+    log << "[INFO]: slots layout decompression throughput "
+        << double(size * config.niteration) / kMegaByte / std::max(slots_drt, 1l) * 1000000ul
+        << " MiB/Second, packed layout takes " << 100.0 * drt / std::max(slots_drt, 1l) << "% of its time" << std::endl;
+    free(slots);
+  }
+
+  if(config.roofline) {
+    //same buffer size and iteration count as the compressor passes, on the same pinned thread
+    MemoryBandwidth bandwidth = measureBandwidth(size, config.niteration);
+    log << "[INFO]: memory bandwidth memcpy " << bandwidth.memcpy << ", streaming read " << bandwidth.read
+        << ", streaming write " << bandwidth.write << " MiB/Second" << std::endl;
+    log << "[INFO]: roofline compression " << 100 * result.compression_throughput / bandwidth.read
+        << "% of streaming read, decompression " << 100 * result.decompression_throughput / bandwidth.write
+        << "% of streaming write, " << 100 * result.decompression_throughput / bandwidth.memcpy
+        << "% of memcpy" << std::endl;
+    result.compression_roofline = result.compression_throughput / bandwidth.read;
+    result.decompression_roofline = result.decompression_throughput / bandwidth.memcpy;
+  }
+
+  if(page_checksum) {
+    //checksum-only pass over the same pages, to separate its cost from decompression
+    uint64_t sink = 0;
+    timer.start();
+    for(size_t i = 0; i < config.niteration; i++) {
+      sink ^= loops.fold(config.checksum, (char*) origin, size / page_size, page_size);
+    }
+    long csum_drt = timer.duration_us();
+    volatile uint64_t keep = sink;//keep the checksum pass from being optimized away
+    (void) keep;
+    log << "[INFO]: checksum " << checksumName(config.checksum) << " throughput "
+        << double(size * config.niteration) / kMegaByte / std::max(csum_drt, 1l) * 1000000ul
+        << " MiB/Second, overhead " << 100.0 * csum_drt / std::max(drt, 1l)
+        << "% of decompression time" << std::endl;
+    if(corrupted_pages) {
+      std::cout << "[ERROR]: checksum mismatch on " << corrupted_pages << " decompressed pages!" << std::endl;
+      result.failed = true;
+    }
+  }
+
+  //gathered blocks hold the last decompressed copy of their pages, put it back into the frames
+  for(size_t bid : scattered) {
+    loops.scatter((char*) origin, block_base[bid], order.data() + bid * npage_per_block, npage_per_block, page_size);
+  }
+
+  if(config.verify) {
+    size_t mismatched = 0;
+    for(size_t bid = 0; bid < nblock; bid++) {
+      if(memcmp((char*) origin + bid * block_size, (char*) pristine + bid * block_size, block_size) != 0) {
+        mismatched++;
+      }
+    }
+    if(short_blocks || mismatched) {
+      std::cout << "[ERROR]: verify failed, " << mismatched << " mismatched blocks, "
+                << short_blocks << " short decompressions" << std::endl;
+      result.failed = true;
+    } else {
+      log << "[INFO]: verify passed, " << nblock << " blocks round-tripped" << std::endl;
+    }
+  }
+
+  free(staging);
+  free(page_checksum);
+  free(pristine);
+  free(block_offset);
+  free(compressed_size);
+  free(compressed);
+  free(origin);
+
+  return result;
+}
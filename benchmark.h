@@ -0,0 +1,283 @@
+#ifndef FASTCOMPRESS_BENCHMARK_H
+#define FASTCOMPRESS_BENCHMARK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+#include "checksum.h"
+
+//default page size, runBenchmark simulates the page size of its config
+static constexpr size_t kPageSize = 4096;
+static constexpr size_t kMegaByte = 0x01 << 20;
+
+/**
+ * @brief unit of the page shuffle: single pages (blocks gather random pages), whole blocks,
+ * regions of shuffle_window pages, or pages displaced only within their window (locality kept)
+ * */
+enum class ShuffleGranularity {
+  Page,
+  Block,
+  Region,
+  Local,
+};
+
+ShuffleGranularity parseShuffleGranularity(const std::string& name);
+
+/**
+ * @brief where compressed blocks live: a fixed 2x slot per block, appended back to back in a
+ * log-structured arena with an offset table, or packed with an extra slots decompression pass
+ * */
+enum class BlockLayout {
+  Slots,
+  Packed,
+  Both,
+};
+
+BlockLayout parseBlockLayout(const std::string& name);
+
+/**
+ * @brief processing order of npages pages: entry i is the page id the i-th processed page reads,
+ * identity when shuffle is off; units never split a block apart unless granularity is Page
+ * */
+std::vector<size_t> pageOrder(size_t npages, bool shuffle, ShuffleGranularity granularity,
+                              size_t block_pages, size_t window, uint64_t seed);
+
+/**
+ * @brief one run of the block compression benchmark: the positional arguments plus flags
+ * */
+struct BenchConfig {
+  std::string path;
+  size_t block_pages = 1;
+  //bytes, a power of two from 4 KiB, e.g. 16 KiB or 64 KiB for arm64/power kernels
+  size_t page_size = kPageSize;
+  size_t niteration = 1;
+  bool page_shuffle = false;
+  ShuffleGranularity shuffle = ShuffleGranularity::Page;
+  size_t shuffle_window = 512;//pages of a region or locality window
+  BlockLayout layout = BlockLayout::Slots;
+  //blocks per decompressBatch call, with the in-tree interleaved decoders switched on; 1 calls decompress
+  size_t interleave = 1;
+  std::string algorithm = "zstd";
+  int level = 0;//compression level of zstd and lz4hc, 0 keeps the engine default
+  bool verify = false;
+  bool same_fill = true;
+  FastCompress::ChecksumType checksum = FastCompress::ChecksumType::None;
+  //print the [INFO] report, modes running many configurations turn it off
+  bool verbose = true;
+  //measure the memory bandwidth ceiling for the same buffer and report throughput against it
+  bool roofline = false;
+  //read the RAPL energy counters around the compression and decompression passes
+  bool energy = false;
+  //load at most this many bytes of the file, 0 loads all of it
+  size_t sample_bytes = 0;
+  //nonzero: capture this process's memory instead of reading path
+  pid_t pid = 0;
+  std::string regions = "heap,stack,anon";
+};
+
+/**
+ * @brief measured outcome of one run, the same quantities the [INFO] report prints
+ * */
+struct BenchResult {
+  size_t file_size = 0;
+  size_t nblocks = 0;
+  double compression_throughput = 0;//MiB/Second
+  double compression_ratio = 0;
+  double decompression_throughput = 0;//MiB/Second
+  //fraction of the memory bandwidth ceiling, set by roofline runs only
+  double compression_roofline = 0;//of streaming read
+  double decompression_roofline = 0;//of memcpy
+  //joules per GiB of original data, set by energy runs only
+  double compression_energy = 0;
+  double decompression_energy = 0;
+  bool failed = false;//verify or checksum mismatch
+};
+
+/**
+ * @brief memory system ceiling of the benchmark thread, MiB/Second of payload moved
+ * */
+struct MemoryBandwidth {
+  double memcpy = 0;//read + write of every byte, the ceiling of a decompressor writing fresh pages
+  double read = 0;//streaming read, the ceiling of a compressor scanning its input
+  double write = 0;//streaming write
+};
+
+/**
+ * @brief time memcpy, streaming read and streaming write over a buffer of bytes, niteration
+ * passes each, best of a few trials
+ * */
+MemoryBandwidth measureBandwidth(size_t bytes, size_t niteration);
+
+/**
+ * @brief copy the resident or swapped pages of a live process's mappings of the listed kinds
+ * (heap, stack, anon) via process_vm_readv, /proc/<pid>/mem as fallback; the process keeps
+ * running, so the snapshot is not atomic
+ * @param limit bytes at most, 0 for no limit
+ * @return page aligned buffer to free(), size set to the captured bytes
+ * */
+void* captureProcess(pid_t pid, const std::string& regions, size_t limit, size_t& size);
+
+/**
+ * @brief load config.path, compress and decompress it block by block niteration times
+ * */
+BenchResult runBenchmark(const BenchConfig& config);
+
+/**
+ * @brief advisor mode: benchmark every algorithm, level and block size on a sample of one input and
+ * recommend the configuration saving the most memory within a cpu and latency budget
+ * */
+struct AdvisorConfig {
+  std::string path;
+  std::vector<std::string> algorithms = {"lz4", "lz4hc", "lzo", "lzo-rle", "zstd", "842"};
+  //swept for the algorithms with a compression level, the others run once
+  std::vector<int> levels = {1, 3, 9};
+  std::vector<size_t> block_pages = {1, 4};
+  size_t sample_bytes = 32 * kMegaByte;
+  size_t niteration = 3;
+  size_t repeat = 3;
+  double cpu_budget = 10;//percent of one core
+  double pages_per_second = 10000;//pages compressed per second
+  double fault_ratio = 1;//decompressions per compressed page
+  double max_latency_us = 0;//per fault, 0 for no limit
+};
+
+int runAdvisor(const AdvisorConfig& advisor);
+
+/**
+ * @brief profiler mode: estimate every algorithm's ratio and throughput on a huge input from a
+ * stratified random sample of its pages, with confidence intervals
+ * */
+struct ProfileConfig {
+  std::string path;
+  std::vector<std::string> algorithms = {"lz4", "lz4hc", "lzo", "lzo-rle", "zstd", "842"};
+  size_t sample_pages = 8192;
+  size_t strata = 64;
+  double confidence = 0.95;
+  uint64_t seed = 1;
+};
+
+int runProfiler(const ProfileConfig& profile);
+
+/**
+ * @brief map mode: per-block compressed size under every algorithm, zero/same-fill class and
+ * byte entropy as csv, plus a zsmalloc size-class histogram of single-page blocks
+ * */
+struct PageMapConfig {
+  std::string path;
+  size_t block_pages = 1;
+  std::vector<std::string> algorithms = {"lz4", "lz4hc", "lzo", "lzo-rle", "zstd", "842"};
+  std::string output;
+};
+
+int runPageMap(const PageMapConfig& map);
+
+/**
+ * @brief swap emulator mode: a userfaultfd-registered region backed by a compressed store,
+ * random accesses under a resident page budget, fault latency distribution per algorithm
+ * */
+struct SwapEmulatorConfig {
+  std::string path;
+  std::vector<std::string> algorithms = {"lz4", "lz4hc", "lzo", "lzo-rle", "zstd", "842"};
+  size_t limit_bytes = 0;//of the file, 0 for all of it
+  double resident_fraction = 0.25;//of the region's pages
+  size_t accesses = 0;//0 for 4 per page
+  double write_ratio = 0.1;
+};
+
+int runSwapEmulator(const SwapEmulatorConfig& swap);
+
+/**
+ * @brief huge page mode: store 2 MiB regions as 4 KiB independent subpages, as one 2 MiB
+ * stream, or as subpages sharing a dictionary sampled from the region, and compare ratio and
+ * per-fault latency when a single subpage is accessed
+ * */
+struct HugePageConfig {
+  std::string path;
+  std::vector<std::string> algorithms = {"lz4", "lz4hc", "lzo", "lzo-rle", "zstd", "842"};
+  size_t limit_bytes = 0;//of the file, 0 for all of it
+  size_t dict_bytes = 16384;
+};
+
+int runHugePage(const HugePageConfig& thp);
+
+/**
+ * @brief store mode: pages in a log-structured compressed store under one writer (hot/cold
+ * overwrites and invalidations) and concurrent readers, with background compaction
+ * */
+struct StoreConfig {
+  std::string path;
+  std::string algorithm = "lz4";
+  size_t limit_bytes = 0;//of the file, 0 for all of it
+  size_t segment_size = 128 * 1024;
+  double slack = 0.25;//space beyond the initial footprint
+  size_t readers = 2;
+  double seconds = 2;
+  double invalidate_ratio = 0.1;//of the writer's operations
+};
+
+int runStore(const StoreConfig& store);
+
+/**
+ * @brief tiered mode: pages stored with a fast algorithm, a background worker recompresses the
+ * ones the access tracker classifies cold with zstd at strong_level, like zram's recompression
+ * */
+struct TieredConfig {
+  std::string path;
+  std::string fast_algorithm = "lz4";
+  int strong_level = 9;
+  size_t limit_bytes = 0;//of the file, 0 for all of it
+  uint64_t cold_ms = 500;//idle time before an infrequently accessed page is cold
+  double seconds = 3;
+  //replay this access trace (page index per line, "w" suffix for writes) instead of the
+  //synthetic hot/cold reader and writer
+  std::string trace;
+};
+
+int runTieredStore(const TieredConfig& tiered);
+
+/**
+ * @brief pipeline mode: one thread producing page batches (classify, dedup lookup), compress
+ * threads, one thread committing into a log-structured store, connected by spsc rings; reports
+ * each stage's busy share to find the one limiting throughput at every thread count
+ * */
+struct PipelineConfig {
+  std::string path;
+  std::string algorithm = "lz4";
+  size_t limit_bytes = 0;//of the file, 0 for all of it
+  std::vector<size_t> workers;//compress thread counts to run, empty for 1, 2, 4 .. cores
+  size_t batch_pages = 32;
+  size_t ring_batches = 8;
+  size_t passes = 4;
+};
+
+int runPipeline(const PipelineConfig& pipeline);
+
+/**
+ * @brief swap readahead simulation: a major fault decompresses the window of neighbouring pages
+ * around it in one batch, with no readahead, a fixed window and one adapted from readahead hits
+ * as the kernel does; reports useful versus wasted decompression and fault latency
+ * */
+struct ReadaheadConfig {
+  std::string path;
+  std::vector<std::string> algorithms = {"lz4", "lzo-rle", "zstd"};
+  size_t limit_bytes = 0;//of the file, 0 for all of it
+  double resident_fraction = 0.25;//swap cache pages, of the file's pages
+  size_t accesses = 0;//0 for 4 per page
+  double sequential = 0.7;//chance an access goes to the page after the previous one
+  size_t max_window = 8;//pages, the kernel's default page-cluster of 3
+  uint64_t seed = 1;
+};
+
+int runReadahead(const ReadaheadConfig& readahead);
+
+/**
+ * @brief regression gate: rerun every configuration of a baseline csv (script.py format)
+ * @return process exit code, nonzero when a significant regression was found
+ * */
+int runRegression(const std::string& baseline, const std::string& data_dir, size_t repeat,
+                  double threshold, double ratio_threshold, const std::string& output);
+
+#endif //FASTCOMPRESS_BENCHMARK_H
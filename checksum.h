@@ -0,0 +1,555 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_CHECKSUM_H
+#define FASTCOMPRESS_CHECKSUM_H
+
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "cpu_features.h"
+
+namespace FastCompress {
+
+/**
+ * @brief Page integrity checksum stored next to every compressed page
+ * */
+enum class ChecksumType {
+  None,
+  CRC32C,
+  XXHash64,
+  XXH3,
+};
+
+template<typename Fn>
+using ChecksumKernel = DispatchKernel<Fn>;
+
+//crc32c kernel: running crc (0 for a fresh checksum) -> crc32c
+using Crc32cFn = uint32_t (*)(uint32_t crc, const void* data, size_t len);
+//64-bit hash kernel, unseeded
+using Hash64Fn = uint64_t (*)(const void* data, size_t len);
+
+namespace detail {
+
+//crc32c (castagnoli) reflected polynomial, same as the SSE4.2 crc32 instruction
+static constexpr uint32_t kCrc32cPoly = 0x82f63b78u;
+
+constexpr std::array<uint32_t, 256> makeCrc32cTable() {
+  std::array<uint32_t, 256> table{};
+  for(uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+    for(int k = 0; k < 8; k++) {
+      crc = (crc >> 1) ^ (kCrc32cPoly & (0u - (crc & 1u)));
+    }
+    table[i] = crc;
+  }
+  return table;
+}
+
+inline constexpr std::array<uint32_t, 256> kCrc32cTable = makeCrc32cTable();
+
+static constexpr uint64_t kXXPrime1 = 0x9e3779b185ebca87ull;
+static constexpr uint64_t kXXPrime2 = 0xc2b2ae3d27d4eb4full;
+static constexpr uint64_t kXXPrime3 = 0x165667b19e3779f9ull;
+static constexpr uint64_t kXXPrime4 = 0x85ebca77c2b2ae63ull;
+static constexpr uint64_t kXXPrime5 = 0x27d4eb2f165667c5ull;
+
+inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t read64(const unsigned char* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t xxRound(uint64_t acc, uint64_t input) {
+  acc += input * kXXPrime2;
+  acc = rotl64(acc, 31);
+  return acc * kXXPrime1;
+}
+
+inline uint64_t xxMergeRound(uint64_t acc, uint64_t val) {
+  acc ^= xxRound(0, val);
+  return acc * kXXPrime1 + kXXPrime4;
+}
+
+inline uint32_t crc32cSoft(uint32_t crc, const void* data, size_t len) {
+  const unsigned char* p = (const unsigned char*)data;
+  crc = ~crc;
+  for(; len > 0; len--, p++) {
+    crc = kCrc32cTable[(crc ^ *p) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+//x^n mod P in the reflected domain, used to shift a crc over n zero bits
+constexpr uint32_t crc32cXPow(size_t n) {
+  uint32_t v = 0x80000000u;
+  for(size_t i = 0; i < n; i++) {
+    v = (v >> 1) ^ (kCrc32cPoly & (0u - (v & 1u)));
+  }
+  return v;
+}
+
+#if defined(__x86_64__)
+__attribute__((target("sse4.2")))
+inline uint32_t crc32cSse42(uint32_t crc, const void* data, size_t len) {
+  const unsigned char* p = (const unsigned char*)data;
+  uint64_t crc64 = ~crc;
+  for(; len >= 8; len -= 8, p += 8) {
+    crc64 = _mm_crc32_u64(crc64, read64(p));
+  }
+  crc = (uint32_t)crc64;
+  for(; len > 0; len--, p++) {
+    crc = _mm_crc32_u8(crc, *p);
+  }
+  return ~crc;
+}
+
+/**
+ * @brief crc32 instruction has 3 cycles latency and 1 cycle throughput, so crc three adjacent
+ * lanes independently, then shift the first two lanes over the following ones with a
+ * carry-less multiply by x^(8*lane-33) and fold the 64-bit product back with one crc32
+ * */
+template<size_t kLane>
+__attribute__((target("sse4.2,pclmul")))
+inline uint64_t crc32cLanes(uint64_t crc, const unsigned char*& p, size_t& len) {
+  static constexpr uint32_t kShift2 = crc32cXPow(8 * 2 * kLane - 33);
+  static constexpr uint32_t kShift1 = crc32cXPow(8 * kLane - 33);
+  while(len >= 3 * kLane) {
+    uint64_t crc0 = crc, crc1 = 0, crc2 = 0;
+    const unsigned char* end = p + kLane;
+    do {
+      crc0 = _mm_crc32_u64(crc0, read64(p));
+      crc1 = _mm_crc32_u64(crc1, read64(p + kLane));
+      crc2 = _mm_crc32_u64(crc2, read64(p + 2 * kLane));
+      p += 8;
+    } while(p < end);
+    __m128i shifted0 = _mm_clmulepi64_si128(_mm_cvtsi64_si128(crc0), _mm_cvtsi32_si128(kShift2), 0x00);
+    __m128i shifted1 = _mm_clmulepi64_si128(_mm_cvtsi64_si128(crc1), _mm_cvtsi32_si128(kShift1), 0x00);
+    crc = crc2 ^ _mm_crc32_u64(0, _mm_cvtsi128_si64(_mm_xor_si128(shifted0, shifted1)));
+    p += 2 * kLane;
+    len -= 3 * kLane;
+  }
+  return crc;
+}
+
+__attribute__((target("sse4.2,pclmul")))
+inline uint32_t crc32cSse42Pclmul(uint32_t crc, const void* data, size_t len) {
+  //3 * 1360 bytes covers a 4 KiB page leaving 16 bytes for the serial tail
+  static constexpr size_t kLongLane = 1360;
+  static constexpr size_t kShortLane = 64;
+  const unsigned char* p = (const unsigned char*)data;
+  uint64_t crc64 = ~crc;
+  crc64 = crc32cLanes<kLongLane>(crc64, p, len);
+  crc64 = crc32cLanes<kShortLane>(crc64, p, len);
+  for(; len >= 8; len -= 8, p += 8) {
+    crc64 = _mm_crc32_u64(crc64, read64(p));
+  }
+  crc = (uint32_t)crc64;
+  for(; len > 0; len--, p++) {
+    crc = _mm_crc32_u8(crc, *p);
+  }
+  return ~crc;
+}
+#endif
+
+//XXH3 (xxhash 0.8) constants
+static constexpr uint32_t kXXPrime32_1 = 0x9e3779b1u;
+static constexpr uint32_t kXXPrime32_2 = 0x85ebca77u;
+static constexpr uint32_t kXXPrime32_3 = 0xc2b2ae3du;
+static constexpr uint64_t kXXPrimeMx1 = 0x165667919e3779f9ull;
+static constexpr uint64_t kXXPrimeMx2 = 0x9fb21c651e98df25ull;
+static constexpr size_t kXXH3StripeLen = 64;
+static constexpr size_t kXXH3SecretConsumeRate = 8;
+static constexpr size_t kXXH3SecretSizeMin = 136;
+
+alignas(64) inline constexpr unsigned char kXXH3Secret[192] = {
+  0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+  0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+  0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+  0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+  0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+  0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+  0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+  0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+  0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+  0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+  0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+  0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+inline uint64_t mul128Fold64(uint64_t lhs, uint64_t rhs) {
+  __uint128_t product = (__uint128_t)lhs * rhs;
+  return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+inline uint64_t xxh64Avalanche(uint64_t h) {
+  h ^= h >> 33;
+  h *= kXXPrime2;
+  h ^= h >> 29;
+  h *= kXXPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+inline uint64_t xxh3Avalanche(uint64_t h) {
+  h ^= h >> 37;
+  h *= kXXPrimeMx1;
+  h ^= h >> 32;
+  return h;
+}
+
+inline uint64_t xxh3Rrmxmx(uint64_t h, uint64_t len) {
+  h ^= rotl64(h, 49) ^ rotl64(h, 24);
+  h *= kXXPrimeMx2;
+  h ^= (h >> 35) + len;
+  h *= kXXPrimeMx2;
+  return h ^ (h >> 28);
+}
+
+inline uint64_t xxh3Mix16B(const unsigned char* input, const unsigned char* secret) {
+  return mul128Fold64(read64(input) ^ read64(secret), read64(input + 8) ^ read64(secret + 8));
+}
+
+//XXH3 64-bit for inputs up to 240 bytes, with the default secret and seed 0
+inline uint64_t xxh3Short(const unsigned char* input, size_t len) {
+  const unsigned char* secret = kXXH3Secret;
+  if(len == 0) {
+    return xxh64Avalanche(read64(secret + 56) ^ read64(secret + 64));
+  }
+  if(len <= 3) {
+    uint32_t combined = ((uint32_t)input[0] << 16) | ((uint32_t)input[len >> 1] << 24)
+                        | (uint32_t)input[len - 1] | ((uint32_t)len << 8);
+    uint64_t bitflip = read32(secret) ^ read32(secret + 4);
+    return xxh64Avalanche((uint64_t)combined ^ bitflip);
+  }
+  if(len <= 8) {
+    uint64_t bitflip = read64(secret + 8) ^ read64(secret + 16);
+    uint64_t input64 = read32(input + len - 4) + ((uint64_t)read32(input) << 32);
+    return xxh3Rrmxmx(input64 ^ bitflip, len);
+  }
+  if(len <= 16) {
+    uint64_t input_lo = read64(input) ^ (read64(secret + 24) ^ read64(secret + 32));
+    uint64_t input_hi = read64(input + len - 8) ^ (read64(secret + 40) ^ read64(secret + 48));
+    uint64_t acc = len + __builtin_bswap64(input_lo) + input_hi + mul128Fold64(input_lo, input_hi);
+    return xxh3Avalanche(acc);
+  }
+  uint64_t acc = len * kXXPrime1;
+  if(len <= 128) {
+    if(len > 32) {
+      if(len > 64) {
+        if(len > 96) {
+          acc += xxh3Mix16B(input + 48, secret + 96);
+          acc += xxh3Mix16B(input + len - 64, secret + 112);
+        }
+        acc += xxh3Mix16B(input + 32, secret + 64);
+        acc += xxh3Mix16B(input + len - 48, secret + 80);
+      }
+      acc += xxh3Mix16B(input + 16, secret + 32);
+      acc += xxh3Mix16B(input + len - 32, secret + 48);
+    }
+    acc += xxh3Mix16B(input, secret);
+    acc += xxh3Mix16B(input + len - 16, secret + 16);
+    return xxh3Avalanche(acc);
+  }
+  //129 to 240 bytes
+  size_t nround = len / 16;
+  for(size_t i = 0; i < 8; i++) {
+    acc += xxh3Mix16B(input + 16 * i, secret + 16 * i);
+  }
+  uint64_t acc_end = xxh3Mix16B(input + len - 16, secret + kXXH3SecretSizeMin - 17);
+  acc = xxh3Avalanche(acc);
+  for(size_t i = 8; i < nround; i++) {
+    acc_end += xxh3Mix16B(input + 16 * i, secret + 16 * (i - 8) + 3);
+  }
+  return xxh3Avalanche(acc + acc_end);
+}
+
+inline uint64_t xxh3MergeAccs(const uint64_t* acc, uint64_t len) {
+  const unsigned char* secret = kXXH3Secret + 11;
+  uint64_t result = len * kXXPrime1;
+  for(size_t i = 0; i < 4; i++) {
+    result += mul128Fold64(acc[2 * i] ^ read64(secret + 16 * i), acc[2 * i + 1] ^ read64(secret + 16 * i + 8));
+  }
+  return xxh3Avalanche(result);
+}
+
+inline void xxh3Accumulate512Scalar(uint64_t* acc, const unsigned char* input, const unsigned char* secret) {
+  for(size_t i = 0; i < 8; i++) {
+    uint64_t data_val = read64(input + 8 * i);
+    uint64_t data_key = data_val ^ read64(secret + 8 * i);
+    acc[i ^ 1] += data_val;
+    acc[i] += (uint64_t)(uint32_t)data_key * (data_key >> 32);
+  }
+}
+
+inline void xxh3ScrambleScalar(uint64_t* acc, const unsigned char* secret) {
+  for(size_t i = 0; i < 8; i++) {
+    uint64_t acc64 = acc[i];
+    acc64 ^= acc64 >> 47;
+    acc64 ^= read64(secret + 8 * i);
+    acc[i] = acc64 * kXXPrime32_1;
+  }
+}
+
+//stripes per block before scrambling, with the 192-byte default secret
+static constexpr size_t kXXH3StripesPerBlock = (sizeof(kXXH3Secret) - kXXH3StripeLen) / kXXH3SecretConsumeRate;
+
+inline uint64_t xxh3Scalar(const void* data, size_t len) {
+  const unsigned char* input = (const unsigned char*)data;
+  if(len <= 240) {
+    return xxh3Short(input, len);
+  }
+  const unsigned char* secret = kXXH3Secret;
+  uint64_t acc[8] = {kXXPrime32_3, kXXPrime1, kXXPrime2, kXXPrime3,
+                     kXXPrime4, kXXPrime32_2, kXXPrime5, kXXPrime32_1};
+  size_t block_len = kXXH3StripeLen * kXXH3StripesPerBlock;
+  size_t nblock = (len - 1) / block_len;
+  for(size_t n = 0; n < nblock; n++) {
+    for(size_t s = 0; s < kXXH3StripesPerBlock; s++) {
+      xxh3Accumulate512Scalar(acc, input + n * block_len + s * kXXH3StripeLen, secret + s * kXXH3SecretConsumeRate);
+    }
+    xxh3ScrambleScalar(acc, secret + sizeof(kXXH3Secret) - kXXH3StripeLen);
+  }
+  size_t nstripe = ((len - 1) - block_len * nblock) / kXXH3StripeLen;
+  for(size_t s = 0; s < nstripe; s++) {
+    xxh3Accumulate512Scalar(acc, input + nblock * block_len + s * kXXH3StripeLen, secret + s * kXXH3SecretConsumeRate);
+  }
+  xxh3Accumulate512Scalar(acc, input + len - kXXH3StripeLen, secret + sizeof(kXXH3Secret) - kXXH3StripeLen - 7);
+  return xxh3MergeAccs(acc, len);
+}
+
+#if defined(__x86_64__)
+__attribute__((target("avx2")))
+inline void xxh3Accumulate512Avx2(__m256i* acc, const unsigned char* input, const unsigned char* secret) {
+  for(size_t i = 0; i < 2; i++) {
+    __m256i data_vec = _mm256_loadu_si256((const __m256i*)(input + 32 * i));
+    __m256i key_vec = _mm256_loadu_si256((const __m256i*)(secret + 32 * i));
+    __m256i data_key = _mm256_xor_si256(data_vec, key_vec);
+    __m256i product = _mm256_mul_epu32(data_key, _mm256_srli_epi64(data_key, 32));
+    __m256i data_swap = _mm256_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2));
+    acc[i] = _mm256_add_epi64(product, _mm256_add_epi64(acc[i], data_swap));
+  }
+}
+
+__attribute__((target("avx2")))
+inline void xxh3ScrambleAvx2(__m256i* acc, const unsigned char* secret) {
+  const __m256i prime32 = _mm256_set1_epi32((int)kXXPrime32_1);
+  for(size_t i = 0; i < 2; i++) {
+    __m256i data_vec = _mm256_xor_si256(acc[i], _mm256_srli_epi64(acc[i], 47));
+    __m256i key_vec = _mm256_loadu_si256((const __m256i*)(secret + 32 * i));
+    __m256i data_key = _mm256_xor_si256(data_vec, key_vec);
+    __m256i data_key_hi = _mm256_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));
+    __m256i prod_lo = _mm256_mul_epu32(data_key, prime32);
+    __m256i prod_hi = _mm256_mul_epu32(data_key_hi, prime32);
+    acc[i] = _mm256_add_epi64(prod_lo, _mm256_slli_epi64(prod_hi, 32));
+  }
+}
+
+__attribute__((target("avx2")))
+inline uint64_t xxh3Avx2(const void* data, size_t len) {
+  const unsigned char* input = (const unsigned char*)data;
+  if(len <= 240) {
+    return xxh3Short(input, len);
+  }
+  const unsigned char* secret = kXXH3Secret;
+  __m256i acc[2] = {
+    _mm256_setr_epi64x(kXXPrime32_3, kXXPrime1, kXXPrime2, kXXPrime3),
+    _mm256_setr_epi64x(kXXPrime4, kXXPrime32_2, kXXPrime5, kXXPrime32_1),
+  };
+  size_t block_len = kXXH3StripeLen * kXXH3StripesPerBlock;
+  size_t nblock = (len - 1) / block_len;
+  for(size_t n = 0; n < nblock; n++) {
+    for(size_t s = 0; s < kXXH3StripesPerBlock; s++) {
+      xxh3Accumulate512Avx2(acc, input + n * block_len + s * kXXH3StripeLen, secret + s * kXXH3SecretConsumeRate);
+    }
+    xxh3ScrambleAvx2(acc, secret + sizeof(kXXH3Secret) - kXXH3StripeLen);
+  }
+  size_t nstripe = ((len - 1) - block_len * nblock) / kXXH3StripeLen;
+  for(size_t s = 0; s < nstripe; s++) {
+    xxh3Accumulate512Avx2(acc, input + nblock * block_len + s * kXXH3StripeLen, secret + s * kXXH3SecretConsumeRate);
+  }
+  xxh3Accumulate512Avx2(acc, input + len - kXXH3StripeLen, secret + sizeof(kXXH3Secret) - kXXH3StripeLen - 7);
+  alignas(32) uint64_t acc64[8];
+  _mm256_store_si256((__m256i*)acc64, acc[0]);
+  _mm256_store_si256((__m256i*)(acc64 + 4), acc[1]);
+  return xxh3MergeAccs(acc64, len);
+}
+#endif
+
+}
+
+/**
+ * @brief crc32c implementations, ordered slowest first
+ * */
+inline const std::vector<ChecksumKernel<Crc32cFn>>& crc32cKernels() {
+  static const std::vector<ChecksumKernel<Crc32cFn>> kernels = {
+    {"soft", anyCpu, detail::crc32cSoft},
+#if defined(__x86_64__)
+    {"sse4.2", hasSse42, detail::crc32cSse42},
+    {"sse4.2-pclmul", hasSse42Pclmul, detail::crc32cSse42Pclmul},
+#endif
+  };
+  return kernels;
+}
+
+/**
+ * @brief XXH3 64-bit implementations, ordered slowest first
+ * */
+inline const std::vector<ChecksumKernel<Hash64Fn>>& xxh3Kernels() {
+  static const std::vector<ChecksumKernel<Hash64Fn>> kernels = {
+    {"scalar", anyCpu, detail::xxh3Scalar},
+#if defined(__x86_64__)
+    {"avx2", hasAvx2, detail::xxh3Avx2},
+#endif
+  };
+  return kernels;
+}
+
+/**
+ * @brief crc32c of a buffer, dispatched at first use to the best kernel of the running cpu
+ * @param data the content to checksum
+ * @param len the length of content
+ * @param crc running crc of previous content, 0 for a fresh checksum
+ * @return crc32c value
+ * */
+inline uint32_t crc32c(const void* data, size_t len, uint32_t crc = 0) {
+  static const Crc32cFn fn = selectKernel(crc32cKernels()).fn;
+  return fn(crc, data, len);
+}
+
+/**
+ * @brief 64-bit XXH3 of a buffer (default secret, seed 0), dispatched at first use
+ * @param data the content to hash
+ * @param len the length of content
+ * @return XXH3_64bits value
+ * */
+inline uint64_t xxh3(const void* data, size_t len) {
+  static const Hash64Fn fn = selectKernel(xxh3Kernels()).fn;
+  return fn(data, len);
+}
+
+
+/**
+ * @brief 64-bit xxhash (XXH64) of a buffer
+ * @param data the content to hash
+ * @param len the length of content
+ * @param seed hash seed
+ * @return XXH64 value
+ * */
+inline uint64_t xxhash64(const void* data, size_t len, uint64_t seed = 0) {
+  using namespace detail;
+  const unsigned char* p = (const unsigned char*)data;
+  const unsigned char* end = p + len;
+  uint64_t h;
+
+  if(len >= 32) {
+    uint64_t v1 = seed + kXXPrime1 + kXXPrime2;
+    uint64_t v2 = seed + kXXPrime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kXXPrime1;
+    const unsigned char* limit = end - 32;
+    do {
+      v1 = xxRound(v1, read64(p));
+      v2 = xxRound(v2, read64(p + 8));
+      v3 = xxRound(v3, read64(p + 16));
+      v4 = xxRound(v4, read64(p + 24));
+      p += 32;
+    } while(p <= limit);
+    h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    h = xxMergeRound(h, v1);
+    h = xxMergeRound(h, v2);
+    h = xxMergeRound(h, v3);
+    h = xxMergeRound(h, v4);
+  } else {
+    h = seed + kXXPrime5;
+  }
+  h += (uint64_t)len;
+
+  for(; p + 8 <= end; p += 8) {
+    h ^= xxRound(0, read64(p));
+    h = rotl64(h, 27) * kXXPrime1 + kXXPrime4;
+  }
+  if(p + 4 <= end) {
+    h ^= (uint64_t)read32(p) * kXXPrime1;
+    h = rotl64(h, 23) * kXXPrime2 + kXXPrime3;
+    p += 4;
+  }
+  for(; p < end; p++) {
+    h ^= (*p) * kXXPrime5;
+    h = rotl64(h, 11) * kXXPrime1;
+  }
+
+  h ^= h >> 33;
+  h *= kXXPrime2;
+  h ^= h >> 29;
+  h *= kXXPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+/**
+ * @brief checksum a page with the selected algorithm
+ * @return checksum value, crc32c is zero extended, 0 for ChecksumType::None
+ * */
+inline uint64_t pageChecksum(ChecksumType type, const void* data, size_t len) {
+  switch(type) {
+    case ChecksumType::CRC32C:
+      return crc32c(data, len);
+    case ChecksumType::XXHash64:
+      return xxhash64(data, len);
+    case ChecksumType::XXH3:
+      return xxh3(data, len);
+    default:
+      return 0;
+  }
+}
+
+inline ChecksumType parseChecksumType(const std::string& name) {
+  if(name == "none") {
+    return ChecksumType::None;
+  } else if(name == "crc32c") {
+    return ChecksumType::CRC32C;
+  } else if(name == "xxhash" || name == "xxhash64") {
+    return ChecksumType::XXHash64;
+  } else if(name == "xxh3") {
+    return ChecksumType::XXH3;
+  } else {
+    throw std::invalid_argument("Unknown checksum algorithm: " + name);
+  }
+}
+
+inline const char* checksumName(ChecksumType type) {
+  switch(type) {
+    case ChecksumType::CRC32C:
+      return "crc32c";
+    case ChecksumType::XXHash64:
+      return "xxhash64";
+    case ChecksumType::XXH3:
+      return "xxh3";
+    default:
+      return "none";
+  }
+}
+
+}
+
+#endif //FASTCOMPRESS_CHECKSUM_H
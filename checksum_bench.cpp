@@ -0,0 +1,78 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "checksum.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+static constexpr size_t kMegaByte = 0x01 << 20;
+static constexpr size_t kGigaByte = 0x01 << 30;
+//bytes hashed per measurement, large enough for the microsecond timer
+static constexpr size_t kBytesPerRun = 256 * kMegaByte;
+
+//hash bufsize bytes in chunks of chunk bytes, repeated until kBytesPerRun, return GiB/s
+template<typename Fn>
+double measure(Fn&& fn, const char* buffer, size_t bufsize, size_t chunk) {
+  size_t nchunk = bufsize / chunk;
+  size_t nround = std::max<size_t>(1, kBytesPerRun / (nchunk * chunk));
+  uint64_t sink = 0;
+  Timer timer;
+  timer.start();
+  for(size_t r = 0; r < nround; r++) {
+    for(size_t c = 0; c < nchunk; c++) {
+      sink += fn(buffer + c * chunk, chunk);
+    }
+  }
+  long drt = std::max(timer.duration_us(), 1l);
+  volatile uint64_t keep = sink;//keep the hashing from being optimized away
+  (void) keep;
+  return double(nround * nchunk * chunk) / kGigaByte / drt * 1000000ul;
+}
+
+int main(int argc, char* argv[]) {
+  //working set of the "memory" run, the "cached" run reuses the first 256 KiB
+  size_t memory_size = argc >= 2 ? std::stoul(argv[1]) * kMegaByte : 256 * kMegaByte;
+  size_t cached_size = 256 * 1024;
+  std::vector<size_t> chunks = {256, 1024, 4096, 16384, 65536};
+
+  PinningMap pin;
+  pin.pinning_thread(0, 0, pthread_self());
+
+  char* buffer = (char*) aligned_alloc(4096, memory_size);
+  std::mt19937_64 generator(42);
+  for(size_t i = 0; i < memory_size / sizeof(uint64_t); i++) {
+    ((uint64_t*) buffer)[i] = generator();
+  }
+
+  std::cout << "[INFO]: cpu features sse4.2 " << cpuFeatures().sse42 << ", pclmul " << cpuFeatures().pclmul
+            << ", avx2 " << cpuFeatures().avx2 << ", avx512f " << cpuFeatures().avx512f << std::endl;
+
+  auto report = [&](const std::string& name, auto&& fn) {
+    for(size_t chunk : chunks) {
+      double cached = measure(fn, buffer, cached_size, chunk);
+      double memory = measure(fn, buffer, memory_size, chunk);
+      std::cout << "[INFO]: " << name << " chunk " << chunk << " bytes, cached "
+                << cached << " GiB/Second, memory " << memory << " GiB/Second" << std::endl;
+    }
+  };
+
+  for(const auto& kernel : crc32cKernels()) {
+    if(kernel.supported()) {
+      report(std::string("crc32c-") + kernel.name,
+             [&](const char* p, size_t n) { return kernel.fn(0, p, n); });
+    }
+  }
+  for(const auto& kernel : xxh3Kernels()) {
+    if(kernel.supported()) {
+      report(std::string("xxh3-") + kernel.name,
+             [&](const char* p, size_t n) { return kernel.fn(p, n); });
+    }
+  }
+  report("xxhash64", [](const char* p, size_t n) { return xxhash64(p, n); });
+
+  free(buffer);
+  return 0;
+}
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#include <stdexcept>
+#include "compress.h"
+
+namespace FastCompress {
+
+bool hasCompressionLevel(const std::string& algorithm) {
+  return algorithm == "zstd" || algorithm == "lz4hc";
+}
+
+std::unique_ptr<LosslessCompressor> createCompressor(const std::string& algorithm, bool same_fill, int level) {
+  if (level != 0 && !hasCompressionLevel(algorithm)) {
+    throw std::invalid_argument("Compression algorithm has no level: " + algorithm);
+  }
+  std::unique_ptr<LosslessCompressor> compressor;
+  if (algorithm == "lz4hc") {
+    compressor = level ? std::make_unique<LZ4HC>(level) : std::make_unique<LZ4HC>();
+  } else if (algorithm == "lz4") {
+    compressor = std::make_unique<LZ4>();
+  } else if (algorithm == "lzo") {
+    compressor = std::make_unique<LZO>();
+  } else if (algorithm == "lzo-rle") {
+    compressor = std::make_unique<LZORLE>();
+  } else if (algorithm == "zstd") {
+    compressor = level ? std::make_unique<ZSTD>(level) : std::make_unique<ZSTD>();
+  } else if (algorithm == "842") {
+    compressor = std::make_unique<Deflate842>();
+  } else {
+    throw std::invalid_argument("Unknown compression algorithm: " + algorithm);
+  }
+  if (same_fill) {
+    compressor = std::make_unique<SameFillFilter>(std::move(compressor));
+  }
+  return compressor;
+}
+
+}
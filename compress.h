@@ -8,17 +8,22 @@
 #define FASTCOMPRESS_COMPRESS_H
 
 
+#include <algorithm>
 #include <cstdint>
 #include <cstddef>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
+#include <string>
 #include <vector>
 #include <zstd.h>
 #include <lz4.h>
 #include <lz4hc.h>
 #include <lzo/lzo1x.h>
 #include <zlib.h>
+#include "rle.h"
+#include "page_scan.h"
 
 namespace FastCompress {
 
@@ -50,6 +55,35 @@ class LosslessCompressor {
    * @return decompressed size written into dst
    * */
   virtual size_t decompress(void* dst, size_t dst_len, void* src, size_t src_len) = 0;
+
+  /**
+   * @brief decompress n independent blocks, e.g. a cluster of faulted pages; lzo-rle's in-tree
+   * rle decoder may interleave up to kMaxRleInterleave of them, the others decode one by one
+   * @param dst n already allocated buffers of dst_len bytes each
+   * @param src n compressed blocks
+   * @param src_len their exact lengths
+   * @param decompressed receives the decompressed size of every block
+   * */
+  virtual void decompressBatch(void* const* dst, size_t dst_len, void* const* src, const size_t* src_len,
+                               size_t* decompressed, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+      decompressed[i] = decompress(dst[i], dst_len, src[i], src_len[i]);
+    }
+  }
+
+  /**
+   * @brief share dict as history between the following compress/decompress calls, both sides
+   * must use the same dictionary; the content is copied, an empty dict clears it
+   * @return false when the algorithm has no dictionary support
+   * */
+  virtual bool setDictionary(const void*, size_t) { return false; }
+
+  /**
+   * @brief let decompressBatch use an in-tree lock-step decoder instead of the library's,
+   * off by default as it only pays off on hosts where it beats the library
+   * @return false when the algorithm has no such decoder
+   * */
+  virtual bool setInterleaved(bool) { return false; }
 };
 
 
@@ -66,10 +100,26 @@ class ZSTD : public LosslessCompressor {
     }
   }
 
-  ~ZSTD() override = default;
+  ~ZSTD() override {
+    clearDictionary();
+    ZSTD_freeCCtx(cctx_);
+    ZSTD_freeDCtx(dctx_);
+  }
 
   size_t compress(void* dst, size_t dst_len, void* src, size_t src_len) override {
-    size_t compressed = ZSTD_compress(dst, dst_len, src, src_len, comp_level_);
+    size_t compressed;
+    if(!dict_.empty()) {
+      //digested dictionary built on first use, a decompress-only side never pays for it
+      if(cdict_ == nullptr) {
+        cdict_ = ZSTD_createCDict(dict_.data(), dict_.size(), comp_level_);
+      }
+      if(cctx_ == nullptr) {
+        cctx_ = ZSTD_createCCtx();
+      }
+      compressed = ZSTD_compress_usingCDict(cctx_, dst, dst_len, src, src_len, cdict_);
+    } else {
+      compressed = ZSTD_compress(dst, dst_len, src, src_len, comp_level_);
+    }
     if(ZSTD_isError(compressed)) {
       std::cout << "[ERROR]: zstd compression error!" << std::endl;
       exit(EXIT_FAILURE);
@@ -78,19 +128,59 @@ class ZSTD : public LosslessCompressor {
   }
 
   size_t decompress(void* dst, size_t dst_len, void* src, size_t src_len) override {
-    size_t decompressed = ZSTD_decompress(dst, dst_len, src, src_len);
+    size_t decompressed;
+    if(!dict_.empty()) {
+      if(ddict_ == nullptr) {
+        ddict_ = ZSTD_createDDict(dict_.data(), dict_.size());
+      }
+      if(dctx_ == nullptr) {
+        dctx_ = ZSTD_createDCtx();
+      }
+      decompressed = ZSTD_decompress_usingDDict(dctx_, dst, dst_len, src, src_len, ddict_);
+    } else {
+      decompressed = ZSTD_decompress(dst, dst_len, src, src_len);
+    }
     if(ZSTD_isError(decompressed)) {
       std::cout << "[ERROR]: zstd decompression error!" << std::endl;
       exit(EXIT_FAILURE);
     }
     return decompressed;
   }
+
+  bool setDictionary(const void* dict, size_t dict_len) override {
+    clearDictionary();
+    dict_.assign((const char*)dict, (const char*)dict + dict_len);
+    return true;
+  }
+
+ private:
+  void clearDictionary() {
+    ZSTD_freeCDict(cdict_);
+    ZSTD_freeDDict(ddict_);
+    cdict_ = nullptr;
+    ddict_ = nullptr;
+    dict_.clear();
+  }
+
+  std::vector<char> dict_;
+  ZSTD_CDict* cdict_ = nullptr;
+  ZSTD_DDict* ddict_ = nullptr;
+  ZSTD_CCtx* cctx_ = nullptr;
+  ZSTD_DCtx* dctx_ = nullptr;
 };
 
 
 class LZ4HC : public LosslessCompressor {
 public:
   LZ4HC() = default;
+
+  explicit LZ4HC(int comp_level) : comp_level_(comp_level) {
+    if(comp_level < 1 || comp_level > LZ4HC_CLEVEL_MAX) {
+      std::cout << "[ERROR]: invalid lz4hc compression level!" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
   ~LZ4HC()  override = default;
   int comp_level_ = 1;
 
@@ -119,7 +209,14 @@ public:
   ~LZ4() override = default;
 
   size_t compress(void* dst, size_t dst_len, void* src, size_t src_len) override {
-    int compressed = LZ4_compress_default((char*)src, (char*)dst, src_len, dst_len);
+    int compressed;
+    if(!dict_.empty()) {
+      //restore the stream state right after loading the dictionary instead of re-hashing it
+      memcpy(&stream_, &dict_stream_, sizeof(stream_));
+      compressed = LZ4_compress_fast_continue(&stream_, (char*)src, (char*)dst, src_len, dst_len, 1);
+    } else {
+      compressed = LZ4_compress_default((char*)src, (char*)dst, src_len, dst_len);
+    }
     if(compressed == 0) {
       std::cout << "[ERROR]: LZ4 compression error!" << std::endl;
       exit(EXIT_FAILURE);
@@ -128,13 +225,29 @@ public:
   }
 
   size_t decompress(void* dst, size_t dst_len, void* src, size_t src_len) override {
-    int decompressed = LZ4_decompress_safe((char*)src, (char *)dst, src_len, dst_len);
+    int decompressed = dict_.empty() ?
+        LZ4_decompress_safe((char*)src, (char *)dst, src_len, dst_len) :
+        LZ4_decompress_safe_usingDict((char*)src, (char*)dst, src_len, dst_len, dict_.data(), dict_.size());
     if(decompressed < 0) {
       std::cout << "[ERROR]: LZ4 decompression error!" << std::endl;
       exit(EXIT_FAILURE);
     }
     return decompressed;
   }
+
+  bool setDictionary(const void* dict, size_t dict_len) override {
+    dict_.assign((const char*)dict, (const char*)dict + dict_len);
+    LZ4_initStream(&dict_stream_, sizeof(dict_stream_));
+    if(!dict_.empty()) {
+      LZ4_loadDict(&dict_stream_, dict_.data(), dict_.size());
+    }
+    return true;
+  }
+
+private:
+  std::vector<char> dict_;
+  LZ4_stream_t dict_stream_;
+  LZ4_stream_t stream_;
 };
 
 class LZO : public LosslessCompressor {
@@ -153,7 +266,7 @@ public:
     int result = lzo1x_1_11_compress(
       (const unsigned char*)src, src_len, 
       (unsigned char*)dst, &compressed_size, 
-      wrkmem_);
+      wrkmem_.data());
     if(result != LZO_E_OK) {
       std::cout << "[ERROR]: LZO compression error!" << std::endl;
       exit(EXIT_FAILURE);
@@ -171,16 +284,15 @@ public:
     return decompressed_size;
   }
 
-  static lzo_uint8_t wrkmem_[LZO1X_1_MEM_COMPRESS];
+private:
+  //per instance, so compressors on different threads never share work memory
+  std::vector<lzo_uint8_t> wrkmem_ = std::vector<lzo_uint8_t>(LZO1X_1_MEM_COMPRESS);
 };
 
-lzo_uint8_t LZO::wrkmem_[LZO1X_1_MEM_COMPRESS];
-
 class LZORLE : public LosslessCompressor {
 public:
   LZORLE() = default;
   ~LZORLE() override = default;
-  static lzo_uint8_t wrkmem_[LZO1X_1_MEM_COMPRESS];
 
   size_t compress(void* dst, size_t dst_len, void* src, size_t src_len) override {
     //step1:lzo compression
@@ -190,36 +302,37 @@ public:
       (lzo_uint)src_len,
       (unsigned char*)dst, 
       &compressed_size, 
-      wrkmem_);
+      wrkmem_.data());
     if(res != LZO_E_OK) {
       std::cout << "[ERROR]: LZO compression error!" <<std::endl;
       exit(EXIT_FAILURE);
     }
 
     //step2:rle compression
-    std::vector<unsigned char> rle_compressed_data;
-    rleCompress((unsigned char*)dst, compressed_size, rle_compressed_data);
+    rle_buffer_.resize(2 * compressed_size);
+    size_t rle_size = rleEncode((unsigned char*)dst, compressed_size, rle_buffer_.data());
 
     //step3:copy rle-compressed data to dst buffer
-    if(rle_compressed_data.size() > dst_len) {
+    if(rle_size > dst_len) {
       std::cout << "[ERROR]: RLE compressed data exceeds destination buffer!" << std::endl;
       exit(EXIT_FAILURE);
     }
-    std::copy(rle_compressed_data.begin(), rle_compressed_data.end(), (unsigned char*)dst);
+    memcpy(dst, rle_buffer_.data(), rle_size);
 
-    return rle_compressed_data.size();
+    return rle_size;
   }
 
   size_t decompress(void* dst, size_t dst_len, void* src, size_t src_len) override {
     //step1:rle decompression
-    std::vector<unsigned char> rle_decompressed_data;
-    rleDecompress((unsigned char*)src, src_len, rle_decompressed_data);
+    size_t rle_decompressed_size = rleDecodedSize((unsigned char*)src, src_len);
+    rle_buffer_.resize(rle_decompressed_size + kRleDecodeSlack);
+    rleDecode((unsigned char*)src, src_len, rle_buffer_.data());
 
     //step2:lzo decompression
     lzo_uint decompressed_size = dst_len;
     int res = lzo1x_decompress(
-      (const unsigned char*)rle_decompressed_data.data(),
-      (lzo_uint)rle_decompressed_data.size(), //注意：这里要用rle解压后的src长度 而不是src_len
+      (const unsigned char*)rle_buffer_.data(),
+      (lzo_uint)rle_decompressed_size, //注意：这里要用rle解压后的src长度 而不是src_len
       (unsigned char*)dst,
       &decompressed_size, 
       nullptr);
@@ -231,40 +344,53 @@ public:
     return decompressed_size;
   }
 
-private:
-  //rle compression func
-  void rleCompress(const unsigned char* input, size_t input_len, std::vector<unsigned char>& output) {
-    size_t i = 0;
-    while(i < input_len) {
-      unsigned char current_byte = input[i];
-      size_t run_length = 1;
-      //find out repeat rate of current byte
-      while(i + 1 < input_len && input[i+ 1] == current_byte && run_length < 255) {
-        i++;
-        run_length++;
+  void decompressBatch(void* const* dst, size_t dst_len, void* const* src, const size_t* src_len,
+                       size_t* decompressed, size_t n) override {
+    if(!interleaved_) {
+      LosslessCompressor::decompressBatch(dst, dst_len, src, src_len, decompressed, n);
+      return;
+    }
+    //the rle stage is in-tree and runs interleaved, lzo then decodes every block on its own
+    for(size_t first = 0; first < n; first += kMaxRleInterleave) {
+      size_t group = std::min(kMaxRleInterleave, n - first);
+      const unsigned char* inputs[kMaxRleInterleave];
+      unsigned char* outputs[kMaxRleInterleave];
+      size_t rle_sizes[kMaxRleInterleave];
+      for(size_t i = 0; i < group; i++) {
+        inputs[i] = (const unsigned char*)src[first + i];
+        rle_sizes[i] = rleDecodedSize(inputs[i], src_len[first + i]);
+        batch_buffers_[i].resize(rle_sizes[i] + kRleDecodeSlack);
+        outputs[i] = batch_buffers_[i].data();
+      }
+      rleDecodeInterleaved(inputs, src_len + first, outputs, group);
+      for(size_t i = 0; i < group; i++) {
+        lzo_uint decompressed_size = dst_len;
+        int res = lzo1x_decompress(outputs[i], (lzo_uint)rle_sizes[i], (unsigned char*)dst[first + i],
+                                   &decompressed_size, nullptr);
+        if(res != LZO_E_OK) {
+          std::cout << "[ERROR]: LZO decompression error!" << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        decompressed[first + i] = decompressed_size;
       }
-      //write rle data
-      output.push_back(current_byte);//byte
-      output.push_back((unsigned char)run_length);//repeat rate
-      i++;
     }
   }
 
-  //rle decompression func
-  void rleDecompress(const unsigned char* input, size_t input_len, std::vector<unsigned char>& output) {
-    size_t i = 0;
-    while(i < input_len) {
-      unsigned char current_byte = input[i++];
-      unsigned char run_length = input[i++];
-      for (size_t j = 0; j < run_length; j++) {
-        output.push_back(current_byte);
-      }
-
-    }
+  bool setInterleaved(bool interleaved) override {
+    interleaved_ = interleaved;
+    return true;
   }
-};
 
-lzo_uint8_t LZORLE::wrkmem_[LZO1X_1_MEM_COMPRESS];
+private:
+  //batches go through decompress one block at a time unless interleaving was asked for
+  bool interleaved_ = false;
+  //per instance, so compressors on different threads never share work memory
+  std::vector<lzo_uint8_t> wrkmem_ = std::vector<lzo_uint8_t>(LZO1X_1_MEM_COMPRESS);
+  //scratch buffer reused across calls, holds rle output before it is copied back into dst
+  std::vector<unsigned char> rle_buffer_;
+  //one rle output per stream of an interleaved batch
+  std::vector<unsigned char> batch_buffers_[kMaxRleInterleave];
+};
 
 //compress()用于已知缓冲区大小 一次性解压
 //注意：在当前类作用域下，没加作用域的compress会解析成自己这个虚函数->无限递归 栈溢出
@@ -297,6 +423,137 @@ public:
   }
 };
 
+/**
+ * @brief zram-style same-filled page elimination in front of any compressor: zero and
+ * same-filled blocks are stored as their length and 64-bit pattern and restored by a fill,
+ * only mixed blocks reach the wrapped compressor. Every output starts with a one byte tag.
+ * */
+class SameFillFilter : public LosslessCompressor {
+ public:
+  enum Tag : unsigned char {
+    kCompressed = 0,
+    kZero = 1,
+    kSameFilled = 2,
+  };
+
+  explicit SameFillFilter(std::unique_ptr<LosslessCompressor> inner) : inner_(std::move(inner)) {}
+
+  ~SameFillFilter() override = default;
+
+  size_t compress(void* dst, size_t dst_len, void* src, size_t src_len) override {
+    unsigned char* out = (unsigned char*)dst;
+    uint64_t pattern;
+    PageClass page_class = classifyPage(src, src_len, &pattern);
+    //the original length goes along, decompress returns it whatever the destination holds
+    uint32_t len = src_len;
+    if(page_class == PageClass::Zero) {
+      zero_blocks_++;
+      out[0] = kZero;
+      memcpy(out + 1, &len, sizeof(len));
+      return 1 + sizeof(len);
+    }
+    if(page_class == PageClass::SameFilled) {
+      same_filled_blocks_++;
+      out[0] = kSameFilled;
+      memcpy(out + 1, &len, sizeof(len));
+      memcpy(out + 1 + sizeof(len), &pattern, sizeof(pattern));
+      return 1 + sizeof(len) + sizeof(pattern);
+    }
+    out[0] = kCompressed;
+    return 1 + inner_->compress(out + 1, dst_len - 1, src, src_len);
+  }
+
+  size_t decompress(void* dst, size_t dst_len, void* src, size_t src_len) override {
+    unsigned char* in = (unsigned char*)src;
+    switch(in[0]) {
+      case kCompressed:
+        return inner_->decompress(dst, dst_len, in + 1, src_len - 1);
+      case kZero:
+      case kSameFilled: {
+        uint32_t len;
+        memcpy(&len, in + 1, sizeof(len));
+        if(len > dst_len) {
+          std::cout << "[ERROR]: same-filled block exceeds destination buffer!" << std::endl;
+          exit(EXIT_FAILURE);
+        }
+        uint64_t pattern = 0;
+        if(in[0] == kSameFilled) {
+          memcpy(&pattern, in + 1 + sizeof(len), sizeof(pattern));
+        }
+        fillPage(dst, len, pattern);
+        return len;
+      }
+      default:
+        std::cout << "[ERROR]: unknown same-fill tag!" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+  }
+
+  void decompressBatch(void* const* dst, size_t dst_len, void* const* src, const size_t* src_len,
+                       size_t* decompressed, size_t n) override {
+    //patterns are filled right away, the compressed blocks go to the inner batch together
+    batch_dst_.clear();
+    batch_src_.clear();
+    batch_len_.clear();
+    batch_index_.clear();
+    for(size_t i = 0; i < n; i++) {
+      unsigned char* in = (unsigned char*)src[i];
+      if(in[0] == kCompressed) {
+        batch_dst_.push_back(dst[i]);
+        batch_src_.push_back(in + 1);
+        batch_len_.push_back(src_len[i] - 1);
+        batch_index_.push_back(i);
+      } else {
+        decompressed[i] = decompress(dst[i], dst_len, src[i], src_len[i]);
+      }
+    }
+    batch_out_.resize(batch_index_.size());
+    inner_->decompressBatch(batch_dst_.data(), dst_len, batch_src_.data(), batch_len_.data(), batch_out_.data(),
+                            batch_index_.size());
+    for(size_t j = 0; j < batch_index_.size(); j++) {
+      decompressed[batch_index_[j]] = batch_out_[j];
+    }
+  }
+
+  bool setDictionary(const void* dict, size_t dict_len) override {
+    return inner_->setDictionary(dict, dict_len);
+  }
+
+  bool setInterleaved(bool interleaved) override {
+    return inner_->setInterleaved(interleaved);
+  }
+
+  LosslessCompressor* inner() { return inner_.get(); }
+
+  size_t zeroBlocks() const { return zero_blocks_; }
+
+  size_t sameFilledBlocks() const { return same_filled_blocks_; }
+
+ private:
+  std::unique_ptr<LosslessCompressor> inner_;
+  //compressed members of the current decompressBatch
+  std::vector<void*> batch_dst_;
+  std::vector<void*> batch_src_;
+  std::vector<size_t> batch_len_;
+  std::vector<size_t> batch_index_;
+  std::vector<size_t> batch_out_;
+  size_t zero_blocks_ = 0;
+  size_t same_filled_blocks_ = 0;
+};
+
+/**
+ * @brief compressor factory: algorithm name -> corresponding compressor
+ * @param algorithm one of lz4, lz4hc, lzo, lzo-rle, zstd, 842
+ * @param same_fill put zero/same-filled block elimination in front of the algorithm
+ * @param level compression level of zstd and lz4hc, 0 keeps the engine default
+ * @throw std::invalid_argument for an unknown algorithm, or a level for one without levels
+ * */
+std::unique_ptr<LosslessCompressor> createCompressor(const std::string& algorithm, bool same_fill = true,
+                                                     int level = 0);
+
+//whether createCompressor takes a level for this algorithm
+bool hasCompressionLevel(const std::string& algorithm);
+
 }
 
 #endif //FASTCOMPRESS_COMPRESS_H
\ No newline at end of file
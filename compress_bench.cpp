@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "compress.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+static constexpr size_t kMegaByte = 0x01 << 20;
+//bytes of each corpus loaded, bounds the working set and the run time per corpus
+static constexpr size_t kCorpusLimit = 8 * kMegaByte;
+//chunks cycled through by one benchmark, so it does not run on a single cached chunk
+static constexpr size_t kMaxChunks = 1024;
+
+/**
+ * @brief one benchmark result, in the spirit of google benchmark's console reporter
+ * */
+struct BenchResult {
+  double ns_per_call = 0;
+  size_t iterations = 0;
+  double p50_ns = 0;
+  double p99_ns = 0;
+};
+
+struct BenchOptions {
+  std::string data_dir = "data";
+  std::vector<std::string> algorithms = {"lz4", "lz4hc", "lzo", "lzo-rle", "zstd", "842"};
+  std::vector<size_t> sizes = {256, 1024, 4096, 16384, 65536};
+  double min_time = 0.05;
+  std::string filter;
+};
+
+std::vector<std::string> splitList(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while(std::getline(stream, item, ',')) {
+    if(!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
+
+/**
+ * @brief batch run (a timing loop, not a multi-block api call): call body(i) in a tight loop,
+ * doubling the iteration count until the loop takes min_time, the time per call then amortizes
+ * timer and loop overhead away
+ * */
+template<typename Body>
+BenchResult runBatch(Body&& body, double min_time) {
+  BenchResult result;
+  Timer timer;
+  for(size_t iterations = 1;; iterations *= 2) {
+    timer.start();
+    for(size_t i = 0; i < iterations; i++) {
+      body(i);
+    }
+    long drt = timer.duration_ns();
+    if(drt >= min_time * 1e9 || iterations >= (1ul << 30)) {
+      result.iterations = iterations;
+      result.ns_per_call = double(drt) / iterations;
+      return result;
+    }
+  }
+}
+
+/**
+ * @brief single run: time every call on its own, reports the per-call latency distribution
+ * (includes about one clock read of overhead per call)
+ * */
+template<typename Body>
+BenchResult runSingle(Body&& body, double min_time) {
+  BenchResult result;
+  std::vector<long> samples;
+  Timer total;
+  Timer timer;
+  total.start();
+  for(size_t i = 0; total.duration_ns() < min_time * 1e9 || samples.size() < 16; i++) {
+    timer.start();
+    body(i);
+    samples.push_back(timer.duration_ns());
+  }
+  std::sort(samples.begin(), samples.end());
+  double sum = 0;
+  for(long sample : samples) {
+    sum += sample;
+  }
+  result.iterations = samples.size();
+  result.ns_per_call = sum / samples.size();
+  result.p50_ns = samples[samples.size() / 2];
+  result.p99_ns = samples[samples.size() * 99 / 100];
+  return result;
+}
+
+//bytes_per_call 0 for results that are not a throughput
+void report(const std::string& name, const BenchResult& result, size_t bytes_per_call) {
+  printf("%-44s %12.0f ns %12zu", name.c_str(), result.ns_per_call, result.iterations);
+  if(bytes_per_call && result.ns_per_call > 0) {
+    printf(" %12.1f MiB/s", bytes_per_call / result.ns_per_call * 1e9 / kMegaByte);
+  } else {
+    printf(" %18s", "-");
+  }
+  if(result.p50_ns > 0) {
+    printf("   p50 %.0f ns p99 %.0f ns", result.p50_ns, result.p99_ns);
+  }
+  printf("\n");
+  fflush(stdout);
+}
+
+//fit time = overhead + size * per_byte over the batch results of one series, weighted by
+//1/time^2 so every size contributes its relative error instead of the largest size dominating
+void reportFit(const std::string& name, const std::vector<size_t>& sizes, const std::vector<double>& ns) {
+  double sw = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+  for(size_t i = 0; i < sizes.size(); i++) {
+    double w = 1.0 / (ns[i] * ns[i]);
+    double x = sizes[i];
+    sw += w;
+    sx += w * x;
+    sy += w * ns[i];
+    sxx += w * x * x;
+    sxy += w * x * ns[i];
+  }
+  double per_byte = (sw * sxy - sx * sy) / (sw * sxx - sx * sx);
+  double overhead = (sy - per_byte * sx) / sw;
+  printf("%-44s per-call overhead %.0f ns, per-byte cost %.3f ns (%.1f MiB/s asymptotic)",
+         name.c_str(), overhead, per_byte, per_byte > 0 ? 1e9 / per_byte / kMegaByte : 0);
+  //a negative intercept means time does not grow linearly with size (cache effects, size
+  //dependent code paths), the split into overhead and per-byte cost is then meaningless
+  if(overhead < 0 || per_byte <= 0) {
+    printf("  [unreliable: not linear in size]");
+  }
+  printf("\n");
+}
+
+bool selected(const BenchOptions& options, const std::string& name) {
+  return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+void benchCorpus(const BenchOptions& options, const std::string& corpus, const std::vector<char>& content) {
+  for(const std::string& algorithm : options.algorithms) {
+    std::string prefix = algorithm + "/" + corpus;
+
+    //context setup: construct a compressor and run its first call on a cold instance, minus
+    //the same call on a warm instance, what remains is construction and first-use setup
+    std::vector<char> scratch(4 * 4096 + 1024);
+    if(selected(options, "setup/" + prefix)) {
+      size_t first_len = std::min<size_t>(4096, content.size());
+      BenchResult setup = runSingle([&](size_t) {
+        std::unique_ptr<LosslessCompressor> compressor = createCompressor(algorithm, false);
+        compressor->compress(scratch.data(), scratch.size(), (void*) content.data(), first_len);
+      }, options.min_time);
+      std::unique_ptr<LosslessCompressor> warm_compressor = createCompressor(algorithm, false);
+      BenchResult warm = runSingle([&](size_t) {
+        warm_compressor->compress(scratch.data(), scratch.size(), (void*) content.data(), first_len);
+      }, options.min_time);
+      setup.ns_per_call = std::max(setup.ns_per_call - warm.ns_per_call, 0.0);
+      setup.p50_ns = std::max(setup.p50_ns - warm.p50_ns, 0.0);
+      setup.p99_ns = std::max(setup.p99_ns - warm.p99_ns, 0.0);
+      report("setup/" + prefix, setup, 0);
+    }
+
+    std::unique_ptr<LosslessCompressor> compressor = createCompressor(algorithm, false);
+    std::vector<double> compress_ns, decompress_ns;
+    std::vector<size_t> fitted_sizes;
+    for(size_t size : options.sizes) {
+      size_t nchunk = std::min(kMaxChunks, content.size() / size);
+      if(nchunk == 0) {
+        continue;
+      }
+      //worst-case expansion of the in-tree formats stays below 4x for small inputs
+      size_t slot = 4 * size + 1024;
+      std::vector<char> compressed(nchunk * slot);
+      std::vector<size_t> compressed_size(nchunk);
+      std::vector<char> decompressed(size);
+      for(size_t c = 0; c < nchunk; c++) {
+        compressed_size[c] = compressor->compress(compressed.data() + c * slot, slot,
+                                                  (void*) (content.data() + c * size), size);
+      }
+
+      auto compress_one = [&](size_t i) {
+        size_t c = i % nchunk;
+        compressor->compress(compressed.data() + c * slot, slot, (void*) (content.data() + c * size), size);
+      };
+      auto decompress_one = [&](size_t i) {
+        size_t c = i % nchunk;
+        compressor->decompress(decompressed.data(), size, compressed.data() + c * slot, compressed_size[c]);
+      };
+
+      std::string suffix = prefix + "/" + std::to_string(size);
+      //batch results also feed the per-call/per-byte fit, so run them when either is selected
+      if(selected(options, "compress/batch/" + suffix) || selected(options, "compress/fit/" + prefix)) {
+        BenchResult batch = runBatch(compress_one, options.min_time);
+        compress_ns.push_back(batch.ns_per_call);
+        if(selected(options, "compress/batch/" + suffix)) {
+          report("compress/batch/" + suffix, batch, size);
+        }
+      }
+      if(selected(options, "compress/single/" + suffix)) {
+        report("compress/single/" + suffix, runSingle(compress_one, options.min_time), size);
+      }
+      if(selected(options, "decompress/batch/" + suffix) || selected(options, "decompress/fit/" + prefix)) {
+        BenchResult batch = runBatch(decompress_one, options.min_time);
+        decompress_ns.push_back(batch.ns_per_call);
+        if(selected(options, "decompress/batch/" + suffix)) {
+          report("decompress/batch/" + suffix, batch, size);
+        }
+      }
+      if(selected(options, "decompress/single/" + suffix)) {
+        report("decompress/single/" + suffix, runSingle(decompress_one, options.min_time), size);
+      }
+      fitted_sizes.push_back(size);
+    }
+    if(fitted_sizes.size() >= 2 && compress_ns.size() == fitted_sizes.size()) {
+      reportFit("compress/fit/" + prefix, fitted_sizes, compress_ns);
+    }
+    if(fitted_sizes.size() >= 2 && decompress_ns.size() == fitted_sizes.size()) {
+      reportFit("decompress/fit/" + prefix, fitted_sizes, decompress_ns);
+    }
+  }
+}
+
+int main(int argc, char* argv[]) {
+  BenchOptions options;
+  for(int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if(arg.rfind("--algorithms=", 0) == 0) {
+      options.algorithms = splitList(arg.substr(strlen("--algorithms=")));
+    } else if(arg.rfind("--sizes=", 0) == 0) {
+      options.sizes.clear();
+      for(const std::string& size : splitList(arg.substr(strlen("--sizes=")))) {
+        options.sizes.push_back(std::stoul(size));
+      }
+    } else if(arg.rfind("--min-time=", 0) == 0) {
+      options.min_time = std::stod(arg.substr(strlen("--min-time=")));
+    } else if(arg.rfind("--filter=", 0) == 0) {
+      options.filter = arg.substr(strlen("--filter="));
+    } else if(arg.rfind("--", 0) == 0) {
+      std::cerr << "[USAGE]: [corpus directory or file, data by default] [--algorithms=lz4,zstd,...]"
+                   " [--sizes=256,4096,...] [--min-time=seconds] [--filter=substring]" << std::endl;
+      exit(EXIT_FAILURE);
+    } else {
+      options.data_dir = arg;
+    }
+  }
+
+  std::vector<std::filesystem::path> corpora;
+  if(std::filesystem::is_directory(options.data_dir)) {
+    for(const auto& entry : std::filesystem::directory_iterator(options.data_dir)) {
+      if(entry.is_regular_file()) {
+        corpora.push_back(entry.path());
+      }
+    }
+    std::sort(corpora.begin(), corpora.end());
+  } else {
+    corpora.push_back(options.data_dir);
+  }
+  if(corpora.empty()) {
+    std::cerr << "[ERROR]: no corpus found in " << options.data_dir << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  PinningMap pin;
+  pin.pinning_thread(0, 0, pthread_self());
+
+  printf("%-44s %15s %12s %18s\n", "Benchmark", "Time", "Iterations", "Throughput");
+  printf("%s\n", std::string(92, '-').c_str());
+  printf("setup: construction and first call, a warm call subtracted; batch: one buffer per call in a\n"
+         "timing loop, time amortized over the loop; single: every call timed on its own\n");
+  printf("%s\n", std::string(92, '-').c_str());
+  for(const auto& path : corpora) {
+    std::ifstream fin(path, std::ios::binary);
+    if(!fin.good()) {
+      std::cerr << "[ERROR]: can't open " << path << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    std::vector<char> content(std::min<size_t>(std::filesystem::file_size(path), kCorpusLimit));
+    fin.read(content.data(), content.size());
+    benchCorpus(options, path.filename().string(), content);
+  }
+  return 0;
+}
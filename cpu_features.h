@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_CPU_FEATURES_H
+#define FASTCOMPRESS_CPU_FEATURES_H
+
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace FastCompress {
+
+/**
+ * @brief instruction set extensions of the running host, detected once via cpuid
+ * */
+struct CpuFeatures {
+  bool sse42 = false;
+  bool pclmul = false;
+  bool avx2 = false;
+  bool avx512f = false;
+  bool avx512bw = false;
+};
+
+/**
+ * @brief detect the host features, FASTCOMPRESS_ISA=scalar|sse4.2|avx2|avx512 caps the
+ * result so every kernel variant of a portable build can be benchmarked on one host; any
+ * other value is an error rather than a silent full-isa run
+ * */
+inline CpuFeatures detectCpuFeatures() {
+  CpuFeatures features;
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_cpu_init();
+  features.sse42 = __builtin_cpu_supports("sse4.2");
+  features.pclmul = __builtin_cpu_supports("pclmul");
+  features.avx2 = __builtin_cpu_supports("avx2");
+  features.avx512f = __builtin_cpu_supports("avx512f");
+  features.avx512bw = __builtin_cpu_supports("avx512bw");
+#endif
+  const char* cap = getenv("FASTCOMPRESS_ISA");
+  if(cap != nullptr) {
+    if(strcmp(cap, "scalar") == 0) {
+      features = CpuFeatures();
+    } else if(strcmp(cap, "sse4.2") == 0) {
+      features.avx2 = features.avx512f = features.avx512bw = false;
+    } else if(strcmp(cap, "avx2") == 0) {
+      features.avx512f = features.avx512bw = false;
+    } else if(strcmp(cap, "avx512") != 0) {
+      std::cerr << "[ERROR]: unknown FASTCOMPRESS_ISA " << cap << " (scalar, sse4.2, avx2, avx512)" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  return features;
+}
+
+inline const CpuFeatures& cpuFeatures() {
+  static const CpuFeatures features = detectCpuFeatures();
+  return features;
+}
+
+inline bool anyCpu() { return true; }
+
+inline bool hasSse42() { return cpuFeatures().sse42; }
+
+inline bool hasSse42Pclmul() { return cpuFeatures().sse42 && cpuFeatures().pclmul; }
+
+inline bool hasAvx2() { return cpuFeatures().avx2; }
+
+inline bool hasAvx512f() { return cpuFeatures().avx512f; }
+
+inline bool hasAvx512bw() { return cpuFeatures().avx512f && cpuFeatures().avx512bw; }
+
+/**
+ * @brief one isa-specific implementation of a kernel, all variants of a kernel produce identical results
+ * */
+template<typename Fn>
+struct DispatchKernel {
+  const char* name;
+  bool (*supported)();
+  Fn fn;
+};
+
+//pick the last (fastest) variant the running cpu supports, variant lists are ordered slowest first
+template<typename Fn>
+const DispatchKernel<Fn>& selectKernel(const std::vector<DispatchKernel<Fn>>& kernels) {
+  const DispatchKernel<Fn>* selected = &kernels.front();
+  for(const auto& kernel : kernels) {
+    if(kernel.supported()) {
+      selected = &kernel;
+    }
+  }
+  return *selected;
+}
+
+}
+
+#endif //FASTCOMPRESS_CPU_FEATURES_H
@@ -0,0 +1,107 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <filesystem>
+#include <fstream>
+#include "energy.h"
+
+//powercap counts in micro-joules
+static constexpr double kJoulesPerMicroJoule = 1e-6;
+
+//intel: power unit register and package energy status, energy unit in bits 12:8
+static constexpr uint32_t kIntelPowerUnit = 0x606;
+static constexpr uint32_t kIntelPackageEnergy = 0x611;
+//amd family 17h and later, same unit layout
+static constexpr uint32_t kAmdPowerUnit = 0xc0010299;
+static constexpr uint32_t kAmdPackageEnergy = 0xc001029b;
+
+static bool readFile(const std::filesystem::path& path, std::string& content) {
+  std::ifstream fin(path);
+  return fin.good() && std::getline(fin, content) && !content.empty();
+}
+
+static bool readMsr(int fd, uint32_t reg, uint64_t& value) {
+  return pread(fd, &value, sizeof(value), reg) == sizeof(value);
+}
+
+EnergyMeter::EnergyMeter() {
+  //powercap: top-level zones are packages, their subzones include dram on servers
+  std::error_code ec;
+  const std::filesystem::path powercap = "/sys/class/powercap";
+  for(const auto& entry : std::filesystem::directory_iterator(powercap, ec)) {
+    std::string zone = entry.path().filename().string();
+    if(zone.rfind("intel-rapl:", 0) != 0) {
+      continue;
+    }
+    std::string name, energy, range;
+    if(!readFile(entry.path() / "name", name) || !readFile(entry.path() / "energy_uj", energy)
+       || !readFile(entry.path() / "max_energy_range_uj", range)) {
+      continue;//unreadable without privileges on recent kernels
+    }
+    //core/uncore subzones are already contained in their package
+    if(name.rfind("package", 0) != 0 && name != "dram") {
+      continue;
+    }
+    Domain domain;
+    domain.path = (entry.path() / "energy_uj").string();
+    domain.range = std::stod(range) * kJoulesPerMicroJoule;
+    domains_.push_back(domain);
+  }
+  if(!domains_.empty()) {
+    source_ = "powercap";
+    return;
+  }
+
+  msr_fd_ = open("/dev/cpu/0/msr", O_RDONLY);
+  if(msr_fd_ < 0) {
+    return;
+  }
+  uint64_t unit = 0, energy = 0;
+  if(readMsr(msr_fd_, kIntelPowerUnit, unit) && readMsr(msr_fd_, kIntelPackageEnergy, energy)) {
+    msr_energy_ = kIntelPackageEnergy;
+  } else if(readMsr(msr_fd_, kAmdPowerUnit, unit) && readMsr(msr_fd_, kAmdPackageEnergy, energy)) {
+    msr_energy_ = kAmdPackageEnergy;
+  } else {
+    close(msr_fd_);
+    msr_fd_ = -1;
+    return;
+  }
+  msr_unit_ = 1.0 / double(1ull << ((unit >> 8) & 0x1f));
+  Domain domain;
+  domain.range = double(1ull << 32) * msr_unit_;//32-bit counter
+  domains_.push_back(domain);
+  source_ = "msr";
+}
+
+EnergyMeter::~EnergyMeter() {
+  if(msr_fd_ >= 0) {
+    close(msr_fd_);
+  }
+}
+
+uint64_t EnergyMeter::readRaw(const Domain& domain) const {
+  if(domain.path.empty()) {
+    uint64_t value = 0;
+    readMsr(msr_fd_, msr_energy_, value);
+    return value & 0xffffffffull;
+  }
+  std::string energy;
+  return readFile(domain.path, energy) ? std::stoull(energy) : 0;
+}
+
+void EnergyMeter::start() {
+  for(Domain& domain : domains_) {
+    domain.start = readRaw(domain);
+  }
+}
+
+double EnergyMeter::joules() {
+  double total = 0;
+  for(const Domain& domain : domains_) {
+    uint64_t now = readRaw(domain);
+    double unit = domain.path.empty() ? msr_unit_ : kJoulesPerMicroJoule;
+    double spent = now >= domain.start ? (now - domain.start) * unit
+                                       : domain.range - (domain.start - now) * unit;
+    total += spent;
+  }
+  return total;
+}
@@ -0,0 +1,49 @@
+#ifndef FASTCOMPRESS_ENERGY_H
+#define FASTCOMPRESS_ENERGY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief cumulative cpu energy from the RAPL counters, read through the powercap sysfs
+ * (package and dram domains of every socket) or, without powercap, the package energy msr
+ * of cpu 0 (intel and amd layouts); used like util::Timer, start() then joules()
+ * */
+class EnergyMeter {
+ public:
+  EnergyMeter();
+
+  ~EnergyMeter();
+
+  EnergyMeter(const EnergyMeter&) = delete;
+
+  EnergyMeter& operator=(const EnergyMeter&) = delete;
+
+  bool available() const { return !domains_.empty(); }
+
+  //"powercap" or "msr", empty when no counter is readable
+  const std::string& source() const { return source_; }
+
+  void start();
+
+  //joules spent since start(), one counter wrap per domain is accounted for
+  double joules();
+
+ private:
+  struct Domain {
+    std::string path;//powercap energy_uj file, empty for the msr counter
+    double range = 0;//counter range in joules, it wraps to zero beyond
+    uint64_t start = 0;
+  };
+
+  uint64_t readRaw(const Domain& domain) const;
+
+  std::vector<Domain> domains_;
+  std::string source_;
+  int msr_fd_ = -1;
+  uint32_t msr_energy_ = 0;//energy status register of the msr source
+  double msr_unit_ = 0;//joules per msr counter tick
+};
+
+#endif //FASTCOMPRESS_ENERGY_H
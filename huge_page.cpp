@@ -0,0 +1,203 @@
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include "compress.h"
+#include "benchmark.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+static constexpr size_t kHugePageSize = 2 * kMegaByte;
+static constexpr size_t kSubpages = kHugePageSize / kPageSize;
+//dictionary chunks sampled evenly across the huge page
+static constexpr size_t kDictChunk = 256;
+
+namespace {
+
+//outcome of one storage strategy over all huge pages of the input
+struct Strategy {
+  size_t compressed = 0;
+  long compress_ns = 0;
+  std::vector<long> fault_ns;//latency until the faulting subpage is readable
+  std::vector<long> first_fault_ns;//shared dictionary: fault that also restores the dictionary
+  bool failed = false;
+};
+
+std::string percentiles(std::vector<long> samples) {
+  if(samples.empty()) {
+    return "none";
+  }
+  std::sort(samples.begin(), samples.end());
+  char text[96];
+  snprintf(text, sizeof(text), "p50 %.2f p99 %.2f us", samples[samples.size() / 2] / 1000.0,
+           samples[std::min(samples.size() - 1, samples.size() * 99 / 100)] / 1000.0);
+  return text;
+}
+
+void report(const std::string& name, const Strategy& strategy, size_t bytes) {
+  std::cout << "[INFO]: " << name << " ratio " << double(bytes) / strategy.compressed << ", compression "
+            << double(bytes) / kMegaByte / std::max(strategy.compress_ns, 1l) * 1e9 << " MiB/Second, fault "
+            << percentiles(strategy.fault_ns);
+  if(!strategy.first_fault_ns.empty()) {
+    std::cout << ", first fault of a huge page " << percentiles(strategy.first_fault_ns);
+  }
+  std::cout << std::endl;
+  if(strategy.failed) {
+    std::cout << "[ERROR]: " << name << " failed to round-trip" << std::endl;
+  }
+}
+
+//evenly spaced chunks of the huge page, a raw-content dictionary every subpage can refer to
+std::vector<char> sampleDictionary(const char* huge, size_t dict_bytes) {
+  size_t nchunk = std::max<size_t>(1, dict_bytes / kDictChunk);
+  std::vector<char> dict;
+  dict.reserve(nchunk * kDictChunk);
+  for(size_t c = 0; c < nchunk; c++) {
+    const char* chunk = huge + c * (kHugePageSize / nchunk);
+    dict.insert(dict.end(), chunk, chunk + kDictChunk);
+  }
+  return dict;
+}
+
+}
+
+int runHugePage(const HugePageConfig& thp) {
+  std::ifstream fin(thp.path);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << thp.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t size = std::filesystem::file_size(thp.path);
+  if(thp.limit_bytes) {
+    size = std::min(size, thp.limit_bytes);
+  }
+  size_t nhuge = size / kHugePageSize;
+  if(nhuge == 0) {
+    std::cerr << "[ERROR]: " << thp.path << " is smaller than a huge page" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size = nhuge * kHugePageSize;
+  char* origin = (char*) aligned_alloc(kPageSize, size);
+  fin.read(origin, size);
+  char* compressed = (char*) aligned_alloc(kPageSize, 2 * size + kHugePageSize);
+  char* restored = (char*) aligned_alloc(kPageSize, kHugePageSize);
+  std::cout << "[INFO]: huge page mode " << thp.path << ", " << nhuge << " huge pages of " << kSubpages
+            << " subpages, shared dictionary " << thp.dict_bytes << " bytes" << std::endl;
+
+  //faults hit subpages in random order, as accesses after a huge page swap-out would
+  std::mt19937 generator(1);
+  std::vector<size_t> order(kSubpages);
+  for(size_t i = 0; i < kSubpages; i++) {
+    order[i] = i;
+  }
+
+  Timer timer;
+  bool failed = false;
+  for(const std::string& algorithm : thp.algorithms) {
+    //4 KiB independent: every subpage its own stream, the split baseline
+    {
+      std::unique_ptr<LosslessCompressor> compressor = createCompressor(algorithm);
+      Strategy strategy;
+      std::vector<size_t> offset(nhuge * kSubpages + 1);
+      timer.start();
+      for(size_t p = 0; p < nhuge * kSubpages; p++) {
+        offset[p + 1] = offset[p] + compressor->compress(compressed + offset[p], 2 * kPageSize,
+                                                         origin + p * kPageSize, kPageSize);
+      }
+      strategy.compress_ns = timer.duration_ns();
+      strategy.compressed = offset.back();
+      for(size_t p = 0; p < nhuge * kSubpages; p++) {
+        timer.start();
+        size_t res = compressor->decompress(restored, kPageSize, compressed + offset[p], offset[p + 1] - offset[p]);
+        strategy.fault_ns.push_back(timer.duration_ns());
+        strategy.failed |= res != kPageSize || memcmp(restored, origin + p * kPageSize, kPageSize) != 0;
+      }
+      report(algorithm + " 4k-independent", strategy, size);
+      failed |= strategy.failed;
+    }
+
+    //2 MiB whole: best ratio, but any fault decompresses all 512 subpages
+    {
+      std::unique_ptr<LosslessCompressor> compressor = createCompressor(algorithm);
+      Strategy strategy;
+      std::vector<size_t> offset(nhuge + 1);
+      timer.start();
+      for(size_t h = 0; h < nhuge; h++) {
+        offset[h + 1] = offset[h] + compressor->compress(compressed + offset[h], 2 * kHugePageSize,
+                                                         origin + h * kHugePageSize, kHugePageSize);
+      }
+      strategy.compress_ns = timer.duration_ns();
+      strategy.compressed = offset.back();
+      for(size_t h = 0; h < nhuge; h++) {
+        timer.start();
+        size_t res = compressor->decompress(restored, kHugePageSize, compressed + offset[h], offset[h + 1] - offset[h]);
+        strategy.fault_ns.push_back(timer.duration_ns());
+        strategy.failed |= res != kHugePageSize || memcmp(restored, origin + h * kHugePageSize, kHugePageSize) != 0;
+      }
+      report(algorithm + " 2m-whole", strategy, size);
+      failed |= strategy.failed;
+    }
+
+    //2 MiB shared dictionary: subpages stay separate streams that split on access, the
+    //dictionary sampled from the huge page carries the cross-subpage redundancy
+    std::unique_ptr<LosslessCompressor> compressor = createCompressor(algorithm);
+    if(!compressor->setDictionary(nullptr, 0)) {
+      std::cout << "[INFO]: " << algorithm << " 2m-shared-dict skipped, no dictionary support" << std::endl;
+      continue;
+    }
+    Strategy strategy;
+    std::vector<size_t> offset(nhuge * (kSubpages + 1) + 1);
+    timer.start();
+    for(size_t h = 0; h < nhuge; h++) {
+      const char* huge = origin + h * kHugePageSize;
+      std::vector<char> dict = sampleDictionary(huge, thp.dict_bytes);
+      size_t slot = h * (kSubpages + 1);
+      //the dictionary itself is stored compressed without a dictionary
+      compressor->setDictionary(nullptr, 0);
+      offset[slot + 1] = offset[slot] + compressor->compress(compressed + offset[slot], 2 * dict.size() + 64,
+                                                             dict.data(), dict.size());
+      compressor->setDictionary(dict.data(), dict.size());
+      for(size_t s = 0; s < kSubpages; s++) {
+        size_t p = slot + 1 + s;
+        offset[p + 1] = offset[p] + compressor->compress(compressed + offset[p], 2 * kPageSize,
+                                                         (void*) (huge + s * kPageSize), kPageSize);
+      }
+    }
+    strategy.compress_ns = timer.duration_ns();
+    strategy.compressed = offset.back();
+
+    std::vector<char> dict(thp.dict_bytes + kDictChunk);
+    for(size_t h = 0; h < nhuge; h++) {
+      size_t slot = h * (kSubpages + 1);
+      std::shuffle(order.begin(), order.end(), generator);
+      for(size_t i = 0; i < kSubpages; i++) {
+        size_t s = order[i];
+        timer.start();
+        if(i == 0) {
+          //first fault of the huge page restores its dictionary, later faults find it cached
+          compressor->setDictionary(nullptr, 0);
+          size_t dict_len = compressor->decompress(dict.data(), dict.size(), compressed + offset[slot],
+                                                   offset[slot + 1] - offset[slot]);
+          compressor->setDictionary(dict.data(), dict_len);
+        }
+        size_t p = slot + 1 + s;
+        size_t res = compressor->decompress(restored, kPageSize, compressed + offset[p], offset[p + 1] - offset[p]);
+        (i == 0 ? strategy.first_fault_ns : strategy.fault_ns).push_back(timer.duration_ns());
+        strategy.failed |= res != kPageSize
+                           || memcmp(restored, origin + h * kHugePageSize + s * kPageSize, kPageSize) != 0;
+      }
+    }
+    report(algorithm + " 2m-shared-dict", strategy, size);
+    failed |= strategy.failed;
+  }
+
+  free(restored);
+  free(compressed);
+  free(origin);
+  return failed ? EXIT_FAILURE : 0;
+}
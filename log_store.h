@@ -0,0 +1,421 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_LOG_STORE_H
+#define FASTCOMPRESS_LOG_STORE_H
+
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FastCompress {
+
+/**
+ * @brief log-structured store of compressed objects (pages) addressed by id.
+ *
+ * Objects are appended to fixed-size segments; overwriting or invalidating an id leaves a
+ * tombstone (the old bytes are only uncounted from their segment's live bytes). A background
+ * thread compacts sealed segments picked by the cost-benefit policy (1 - u) * age / (1 + u),
+ * relocating live objects into its own head segment so cold data is segregated from new writes.
+ *
+ * Readers resolve an id through an indirection table of packed locations and pin the segment
+ * while they read; compaction swings table entries with compare-and-swap and recycles a victim
+ * only once no reader pins it, so readers never wait for compaction. Writers only block when
+ * every segment is in use and compaction has not freed one yet.
+ * */
+class LogStore {
+ public:
+  struct Stats {
+    size_t appended_bytes = 0;//by writers, headers included
+    size_t relocated_bytes = 0;//by compaction
+    size_t compacted_segments = 0;
+    size_t write_stalls = 0;//appends that waited for a free segment
+    size_t live_bytes = 0;
+    size_t used_segments = 0;
+  };
+
+  /**
+   * @param nobject ids are 0 .. nobject - 1
+   * @param segment_size bytes per segment, objects never span segments, at most 16 MiB
+   * @param max_segments the store never allocates more, compaction keeps free ones around
+   * */
+  LogStore(size_t nobject, size_t segment_size, size_t max_segments)
+      : segment_size_(segment_size), table_(nobject), generations_(nobject), segments_(max_segments) {
+    //a location addresses offsets within a segment in kOffsetBits
+    if(segment_size > (1ull << kOffsetBits)) {
+      std::cout << "[ERROR]: log store segments hold at most " << ((1ull << kOffsetBits) >> 10) << " KiB!"
+                << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    for(std::atomic<uint64_t>& entry : table_) {
+      entry.store(0, std::memory_order_relaxed);
+    }
+    for(std::atomic<uint64_t>& generation : generations_) {
+      generation.store(0, std::memory_order_relaxed);
+    }
+    for(size_t s = max_segments; s > 0; s--) {
+      free_.push_back(s - 1);
+    }
+    compactor_ = std::thread([this]() { compactLoop(); });
+  }
+
+  ~LogStore() {
+    {
+      std::lock_guard<std::mutex> lock(free_mutex_);
+      stop_ = true;
+    }
+    compact_cv_.notify_all();
+    compactor_.join();
+    for(Segment& segment : segments_) {
+      free(segment.data);
+    }
+  }
+
+  LogStore(const LogStore&) = delete;
+
+  LogStore& operator=(const LogStore&) = delete;
+
+  /**
+   * @brief store a new version of id, the previous one becomes a tombstone
+   * @return false when len does not fit into a segment
+   * */
+  bool put(size_t id, const void* data, size_t len) {
+    std::lock_guard<std::mutex> lock(write_head_.mutex);
+    uint64_t location = append(write_head_, id, data, len, true);
+    if(location == 0) {
+      return false;
+    }
+    swing(id, location);
+    generations_[id].fetch_add(1, std::memory_order_seq_cst);
+    return true;
+  }
+
+  //generation of id, every put, replace and invalidate advances it, relocation does not
+  uint64_t version(size_t id) const { return generations_[id].load(std::memory_order_seq_cst); }
+
+  /**
+   * @brief store a new version of id only if its current version is still expected, so a
+   * background rewrite never overwrites a newer put
+   * @return whether the new version replaced the expected one
+   * */
+  bool replace(size_t id, uint64_t expected, const void* data, size_t len) {
+    //generations only change under the write lock, past this check just compaction moves the entry
+    std::lock_guard<std::mutex> lock(write_head_.mutex);
+    if(generations_[id].load(std::memory_order_seq_cst) != expected
+       || table_[id].load(std::memory_order_seq_cst) == 0) {
+      return false;
+    }
+    uint64_t location = append(write_head_, id, data, len, true);
+    if(location == 0) {
+      return false;
+    }
+    swing(id, location);
+    generations_[id].fetch_add(1, std::memory_order_seq_cst);
+    return true;
+  }
+
+  //drop id, its bytes become a tombstone
+  void invalidate(size_t id) {
+    std::lock_guard<std::mutex> lock(write_head_.mutex);
+    swing(id, 0);
+    generations_[id].fetch_add(1, std::memory_order_seq_cst);
+  }
+
+  /**
+   * @brief call fn(data, len) on the current version of id while its segment is pinned
+   * @param version if given, set to the version token of the bytes fn saw
+   * @return false when id holds no object
+   * */
+  template<typename Fn>
+  bool read(size_t id, Fn&& fn, uint64_t* version = nullptr) {
+    for(;;) {
+      //generation first: writers advance it after swinging the entry, so a stale pair only
+      //ever makes a later replace() fail
+      uint64_t generation = generations_[id].load(std::memory_order_seq_cst);
+      uint64_t location = table_[id].load(std::memory_order_seq_cst);
+      if(location == 0) {
+        return false;
+      }
+      Segment& segment = segments_[segmentOf(location)];
+      segment.readers.fetch_add(1, std::memory_order_seq_cst);
+      //recheck after pinning: compaction may have moved the object and recycled the segment
+      if(table_[id].load(std::memory_order_seq_cst) == location) {
+        if(version != nullptr) {
+          *version = generation;
+        }
+        fn((const char*) segment.data + offsetOf(location) + kHeaderSize, lengthOf(location));
+        segment.readers.fetch_sub(1, std::memory_order_release);
+        return true;
+      }
+      segment.readers.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  Stats stats() {
+    Stats stats;
+    stats.appended_bytes = appended_bytes_.load(std::memory_order_relaxed);
+    stats.relocated_bytes = relocated_bytes_.load(std::memory_order_relaxed);
+    stats.compacted_segments = compacted_segments_.load(std::memory_order_relaxed);
+    stats.write_stalls = write_stalls_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    for(Segment& segment : segments_) {
+      stats.live_bytes += segment.live.load(std::memory_order_relaxed);
+    }
+    stats.used_segments = segments_.size() - free_.size();
+    return stats;
+  }
+
+ private:
+  //object header in the segment: id and payload length, payloads are 8-byte aligned
+  static constexpr size_t kHeaderSize = 16;
+  static constexpr unsigned kOffsetBits = 24;
+  static constexpr unsigned kLengthBits = 20;
+  //compaction keeps at least this many segments free for the writers
+  static constexpr size_t kFreeLowWatermark = 2;
+  static constexpr size_t kFreeHighWatermark = 4;
+
+  struct Segment {
+    char* data = nullptr;
+    size_t used = 0;//bytes appended, guarded by the owning head
+    bool sealed = false;
+    uint64_t sealed_at = 0;//logical clock, the age of cost-benefit
+    std::atomic<size_t> live{0};
+    std::atomic<size_t> readers{0};//pins of readers and of writers retiring bytes in it
+  };
+
+  //append point of the writers or of compaction
+  struct Head {
+    std::mutex mutex;
+    size_t segment = SIZE_MAX;
+  };
+
+  static uint64_t pack(size_t segment, size_t offset, size_t len) {
+    return ((uint64_t) (segment + 1) << (kOffsetBits + kLengthBits)) | ((uint64_t) offset << kLengthBits) | len;
+  }
+
+  static size_t segmentOf(uint64_t location) { return (location >> (kOffsetBits + kLengthBits)) - 1; }
+
+  static size_t offsetOf(uint64_t location) { return (location >> kLengthBits) & ((1ull << kOffsetBits) - 1); }
+
+  static size_t lengthOf(uint64_t location) { return location & ((1ull << kLengthBits) - 1); }
+
+  static size_t footprint(size_t len) { return kHeaderSize + (len + 7) / 8 * 8; }
+
+  void retire(uint64_t location) {
+    if(location != 0) {
+      segments_[segmentOf(location)].live.fetch_sub(footprint(lengthOf(location)), std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * @brief point id at location (0 drops it) and retire the bytes it pointed at before. Their
+   * segment stays pinned from before the swap until after the retire: compaction skips the old
+   * object as a tombstone once the swap is visible, and could otherwise recycle the segment
+   * before the retire lands on its reset live count
+   * */
+  void swing(size_t id, uint64_t location) {
+    for(;;) {
+      uint64_t old = table_[id].load(std::memory_order_seq_cst);
+      if(old == 0) {
+        if(table_[id].compare_exchange_strong(old, location, std::memory_order_seq_cst)) {
+          return;
+        }
+        continue;
+      }
+      Segment& old_segment = segments_[segmentOf(old)];
+      old_segment.readers.fetch_add(1, std::memory_order_seq_cst);
+      //compaction relocating the object in between makes the swap fail, and the loop pins anew
+      bool swapped = table_[id].compare_exchange_strong(old, location, std::memory_order_seq_cst);
+      if(swapped) {
+        retire(old);
+      }
+      old_segment.readers.fetch_sub(1, std::memory_order_release);
+      if(swapped) {
+        return;
+      }
+    }
+  }
+
+  //seal the head's segment and open a free one, writers wait for compaction when none is left
+  bool advance(Head& head, bool writer) {
+    std::unique_lock<std::mutex> lock(free_mutex_);
+    if(head.segment != SIZE_MAX) {
+      segments_[head.segment].sealed = true;
+      segments_[head.segment].sealed_at = clock_++;
+    }
+    if(writer && free_.size() <= kFreeLowWatermark) {
+      compact_cv_.notify_one();
+    }
+    //compaction may dip into the last free segments, writers leave one for it
+    size_t reserve = writer ? 1 : 0;
+    if(free_.size() <= reserve) {
+      if(!writer) {
+        head.segment = SIZE_MAX;
+        return false;
+      }
+      write_stalls_.fetch_add(1, std::memory_order_relaxed);
+      free_cv_.wait(lock, [&]() { return free_.size() > reserve || stop_; });
+      if(stop_) {
+        return false;
+      }
+    }
+    head.segment = free_.back();
+    free_.pop_back();
+    Segment& segment = segments_[head.segment];
+    if(segment.data == nullptr) {
+      segment.data = (char*) aligned_alloc(4096, segment_size_);
+    }
+    segment.used = 0;
+    segment.sealed = false;
+    return true;
+  }
+
+  //copy one object to the head, returns its location or 0
+  uint64_t append(Head& head, size_t id, const void* data, size_t len, bool writer) {
+    size_t need = footprint(len);
+    if(need > segment_size_ || len >= (1ull << kLengthBits)) {
+      return 0;
+    }
+    if(head.segment == SIZE_MAX || segments_[head.segment].used + need > segment_size_) {
+      if(!advance(head, writer)) {
+        return 0;
+      }
+    }
+    Segment& segment = segments_[head.segment];
+    size_t offset = segment.used;
+    uint64_t header[2] = {id, len};
+    memcpy(segment.data + offset, header, sizeof(header));
+    memcpy(segment.data + offset + kHeaderSize, data, len);
+    segment.used += need;
+    segment.live.fetch_add(need, std::memory_order_relaxed);
+    (writer ? appended_bytes_ : relocated_bytes_).fetch_add(need, std::memory_order_relaxed);
+    return pack(head.segment, offset, len);
+  }
+
+  //sealed segment with the best (1 - u) * age / (1 + u), SIZE_MAX when none pays off
+  size_t pickVictim() {
+    std::lock_guard<std::mutex> lock(free_mutex_);
+    size_t victim = SIZE_MAX;
+    double best = 0;
+    for(size_t s = 0; s < segments_.size(); s++) {
+      Segment& segment = segments_[s];
+      if(!segment.sealed || s == compact_head_.segment) {
+        continue;
+      }
+      double u = double(segment.live.load(std::memory_order_relaxed)) / segment_size_;
+      double score = (1 - u) * double(clock_ - segment.sealed_at + 1) / (1 + u);
+      if(u < 1 && score > best) {
+        best = score;
+        victim = s;
+      }
+    }
+    return victim;
+  }
+
+  //relocate the live objects of victim and recycle it, false when there was no room to relocate
+  bool compactSegment(size_t victim) {
+    Segment& segment = segments_[victim];
+    std::lock_guard<std::mutex> lock(compact_head_.mutex);
+    for(size_t offset = 0; offset < segment.used;) {
+      uint64_t header[2];
+      memcpy(header, segment.data + offset, sizeof(header));
+      size_t id = header[0], len = header[1];
+      uint64_t old_location = pack(victim, offset, len);
+      offset += footprint(len);
+      if(table_[id].load(std::memory_order_seq_cst) != old_location) {
+        continue;//tombstone: overwritten or invalidated since
+      }
+      uint64_t new_location = append(compact_head_, id, segment.data + offsetOf(old_location) + kHeaderSize, len, false);
+      if(new_location == 0) {
+        return false;//no room to relocate into, the victim keeps its remaining objects
+      }
+      uint64_t expected = old_location;
+      if(table_[id].compare_exchange_strong(expected, new_location, std::memory_order_seq_cst)) {
+        segment.live.fetch_sub(footprint(len), std::memory_order_relaxed);
+      } else {
+        retire(new_location);//a writer won the race, the relocated copy is dead on arrival
+      }
+    }
+    //every entry points elsewhere now, wait out readers that pinned the victim before
+    while(segment.readers.load(std::memory_order_seq_cst) != 0) {
+      std::this_thread::yield();
+    }
+    {
+      std::lock_guard<std::mutex> free_lock(free_mutex_);
+      segment.sealed = false;
+      segment.used = 0;
+      segment.live.store(0, std::memory_order_relaxed);
+      free_.push_back(victim);
+    }
+    compacted_segments_.fetch_add(1, std::memory_order_relaxed);
+    free_cv_.notify_all();
+    return true;
+  }
+
+  void compactLoop() {
+    for(;;) {
+      {
+        std::unique_lock<std::mutex> lock(free_mutex_);
+        compact_cv_.wait(lock, [&]() { return free_.size() <= kFreeLowWatermark || stop_; });
+        if(stop_) {
+          return;
+        }
+      }
+      //compact until the writers have headroom again or nothing is worth moving
+      bool progress = false;
+      for(;;) {
+        {
+          std::lock_guard<std::mutex> lock(free_mutex_);
+          if(free_.size() >= kFreeHighWatermark || stop_) {
+            break;
+          }
+        }
+        size_t victim = pickVictim();
+        if(victim == SIZE_MAX || !compactSegment(victim)) {
+          break;
+        }
+        progress = true;
+      }
+      if(!progress) {
+        //every sealed segment is fully live, only new tombstones can change that
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+  }
+
+  size_t segment_size_;
+  std::vector<std::atomic<uint64_t>> table_;
+  //per id, so a replace() cannot mistake a newer put landing at a recycled location for its version
+  std::vector<std::atomic<uint64_t>> generations_;
+  std::vector<Segment> segments_;
+  std::vector<size_t> free_;
+  std::mutex free_mutex_;
+  std::condition_variable free_cv_;
+  std::condition_variable compact_cv_;
+  uint64_t clock_ = 0;
+  bool stop_ = false;
+  Head write_head_;
+  Head compact_head_;
+  std::atomic<size_t> appended_bytes_{0};
+  std::atomic<size_t> relocated_bytes_{0};
+  std::atomic<size_t> compacted_segments_{0};
+  std::atomic<size_t> write_stalls_{0};
+  std::thread compactor_;
+};
+
+}
+
+#endif //FASTCOMPRESS_LOG_STORE_H
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_LZ4_DECODE_H
+#define FASTCOMPRESS_LZ4_DECODE_H
+
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace FastCompress {
+
+/**
+ * in-tree decoder of the lz4 block format (what LZ4_compress_default produces), so several
+ * independent blocks can be decoded in lock-step: one sequence of every stream per round, the
+ * serial token -> length -> copy chain of each stream then overlaps with the others' on an
+ * out-of-order core instead of stalling on its own loads; a benchmark experiment (--interleave),
+ * not part of the installed library, as it has not beaten liblz4's decoder
+ * */
+
+//streams a lock-step decode interleaves at most
+static constexpr size_t kMaxInterleave = 4;
+
+namespace detail {
+
+struct Lz4Stream {
+  const unsigned char* ip;
+  const unsigned char* iend;
+  unsigned char* op;
+  unsigned char* ostart;
+  unsigned char* oend;
+  bool done = false;
+  bool failed = false;
+};
+
+//extra length bytes after a 15 in the token: 255 continues, anything lower ends it
+__attribute__((always_inline)) inline bool lz4ReadLength(Lz4Stream& s, size_t& length) {
+  unsigned char byte;
+  do {
+    if(s.ip >= s.iend) {
+      return false;
+    }
+    byte = *s.ip++;
+    length += byte;
+  } while(byte == 255);
+  return true;
+}
+
+/**
+ * @brief decode one sequence (literals, then a match unless this is the last sequence)
+ * @return false once the stream finished or failed
+ * */
+__attribute__((always_inline)) inline bool lz4Step(Lz4Stream& s) {
+  if(s.iend - s.ip >= 32 && s.oend - s.op >= 64) {
+    //common case without a length byte, a far match and room to spare: fixed-size copies
+    //and a single well-predicted branch, what lets interleaved streams overlap
+    unsigned token = s.ip[0];
+    size_t literals = token >> 4;
+    size_t offset = s.ip[1 + literals] | (s.ip[2 + literals] << 8);
+    if(literals < 15 && (token & 15) < 15 && offset >= 16 && offset <= size_t(s.op - s.ostart) + literals) {
+      memcpy(s.op, s.ip + 1, 16);
+      s.op += literals;
+      s.ip += 3 + literals;
+      const unsigned char* match = s.op - offset;
+      memcpy(s.op, match, 16);
+      memcpy(s.op + 16, match + 16, 4);
+      s.op += (token & 15) + 4;
+      return true;
+    }
+  }
+  if(s.ip >= s.iend) {
+    s.failed = true;
+    return false;
+  }
+  unsigned token = *s.ip++;
+  size_t literals = token >> 4;
+  if(literals == 15 && !lz4ReadLength(s, literals)) {
+    s.failed = true;
+    return false;
+  }
+  if(literals <= 16 && s.iend - s.ip >= 16 && s.oend - s.op >= 16) {
+    //short literal run: one fixed 16-byte copy, the bytes past the run are overwritten later
+    memcpy(s.op, s.ip, 16);
+  } else if(literals <= size_t(s.iend - s.ip) && literals <= size_t(s.oend - s.op)) {
+    memcpy(s.op, s.ip, literals);
+  } else {
+    s.failed = true;
+    return false;
+  }
+  s.op += literals;
+  s.ip += literals;
+  if(s.ip == s.iend) {
+    s.done = true;//the last sequence has literals only
+    return false;
+  }
+
+  if(s.iend - s.ip < 2) {
+    s.failed = true;
+    return false;
+  }
+  size_t offset = s.ip[0] | (s.ip[1] << 8);
+  s.ip += 2;
+  size_t length = (token & 15) + 4;
+  if((token & 15) == 15 && !lz4ReadLength(s, length)) {
+    s.failed = true;
+    return false;
+  }
+  if(offset == 0 || offset > size_t(s.op - s.ostart) || length > size_t(s.oend - s.op)) {
+    s.failed = true;
+    return false;
+  }
+  const unsigned char* match = s.op - offset;
+  size_t room = s.oend - s.op;
+  if(offset >= 16 && length + 16 <= room) {
+    //16-byte chunks may run up to 15 bytes past the match end, still inside the output
+    unsigned char* end = s.op + length;
+    for(; s.op < end; s.op += 16, match += 16) {
+      memcpy(s.op, match, 16);
+    }
+    s.op = end;
+  } else if(offset >= 8 && length + 8 <= room) {
+    unsigned char* end = s.op + length;
+    for(; s.op < end; s.op += 8, match += 8) {
+      memcpy(s.op, match, 8);
+    }
+    s.op = end;
+  } else {
+    //overlapping match repeats the last offset bytes, or too close to the output end
+    for(size_t i = 0; i < length; i++) {
+      s.op[i] = match[i];
+    }
+    s.op += length;
+  }
+  return true;
+}
+
+//N streams with a compile-time count, so the round over them unrolls
+template<size_t N>
+inline void lz4DecodeLockstep(const void* const* src, const size_t* src_len, void* const* dst, size_t dst_len,
+                              int* result) {
+  Lz4Stream streams[N];
+  for(size_t s = 0; s < N; s++) {
+    streams[s].ip = (const unsigned char*) src[s];
+    streams[s].iend = streams[s].ip + src_len[s];
+    streams[s].op = streams[s].ostart = (unsigned char*) dst[s];
+    streams[s].oend = streams[s].op + dst_len;
+  }
+  //every stream advances while all of them have sequences left, the rest finish one by one
+  bool running = true;
+  while(running) {
+    for(size_t s = 0; s < N; s++) {
+      running &= lz4Step(streams[s]);
+    }
+  }
+  for(size_t s = 0; s < N; s++) {
+    while(!streams[s].done && !streams[s].failed && lz4Step(streams[s])) {
+    }
+    result[s] = streams[s].failed ? -1 : int(streams[s].op - streams[s].ostart);
+  }
+}
+
+}
+
+/**
+ * @brief decode n <= kMaxInterleave independent lz4 blocks, one sequence of each per round
+ * @param result receives every stream's decoded size, or -1 for a malformed block
+ * */
+inline void lz4DecodeInterleaved(const void* const* src, const size_t* src_len, void* const* dst, size_t dst_len,
+                                 int* result, size_t n) {
+  switch(n) {
+    case 0:
+      return;
+    case 1:
+      detail::lz4DecodeLockstep<1>(src, src_len, dst, dst_len, result);
+      return;
+    case 2:
+      detail::lz4DecodeLockstep<2>(src, src_len, dst, dst_len, result);
+      return;
+    case 3:
+      detail::lz4DecodeLockstep<3>(src, src_len, dst, dst_len, result);
+      return;
+    default:
+      detail::lz4DecodeLockstep<4>(src, src_len, dst, dst_len, result);
+  }
+}
+
+}
+
+#endif //FASTCOMPRESS_LZ4_DECODE_H
@@ -1,137 +1,347 @@
 #include <iostream>
-#include <fstream>
-#include <filesystem>
-#include <algorithm>
-#include <random>
-#include <memory>
-#include <unordered_map>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "compress.h"
+#include "checksum.h"
+#include "benchmark.h"
 #include "util.h"
 
 using namespace FastCompress;
 using namespace util;
 
-static constexpr size_t kPageSize = 4096;
-static constexpr size_t kMegaByte = 0x01 << 20;
+static void usage() {
+  std::cerr << "[USAGE]: file path, block size [n pages], number of iteration,"
+               " [page random shuffle, false by default], [algorithm, zstd by default]"
+               " [--level=n] [--verify] [--roofline] [--energy] [--checksum=none|crc32c|xxhash|xxh3] [--same-fill=0|1]"
+               " [--page-size=4096|16384|65536] [--shuffle=page|block|region|local] [--shuffle-window=n pages]"
+               " [--layout=slots|packed|both] [--interleave=n blocks]\n"
+               "         --pid=n [--regions=heap,stack,anon] [--limit-mb=n], block size [n pages],"
+               " number of iteration, ... (same as above, a live process replaces the file)\n"
+               "         --baseline=results.csv [--data=dir] [--repeat=n] [--threshold=fraction]"
+               " [--ratio-threshold=fraction] [--output=results.csv]\n"
+               "         file path --advise [--cpu-budget=percent] [--pages-per-second=n] [--fault-ratio=n]"
+               " [--max-latency-us=n] [--sample-mb=n] [--algorithms=lz4,zstd,...] [--levels=1,3,9,...]"
+               " [--blocks=1,4,...] [--repeat=n]\n"
+               "         file path --profile [--sample-pages=n] [--strata=n] [--confidence=fraction] [--seed=n]"
+               " [--algorithms=lz4,zstd,...]\n"
+               "         file path --swap [--resident=fraction] [--accesses=n] [--write-ratio=fraction]"
+               " [--limit-mb=n] [--algorithms=lz4,zstd,...]\n"
+               "         file path --readahead [--max-window=n pages] [--sequential=fraction] [--resident=fraction]"
+               " [--accesses=n] [--seed=n] [--limit-mb=n] [--algorithms=lz4,zstd,...]\n"
+               "         file path --thp [--dict-kb=n] [--limit-mb=n] [--algorithms=lz4,zstd,...]\n"
+               "         file path --store [--algorithm=lz4] [--segment-kb=n] [--slack=fraction] [--readers=n]"
+               " [--seconds=n] [--invalidate-ratio=fraction] [--limit-mb=n]\n"
+               "         file path --tiered [--algorithm=lz4] [--strong-level=n] [--cold-ms=n] [--seconds=n]"
+               " [--trace=file] [--limit-mb=n]\n"
+               "         file path --pipeline [--algorithm=lz4] [--workers=1,2,4,...] [--batch-pages=n] [--ring=n batches]"
+               " [--passes=n] [--limit-mb=n]\n"
+               "         file path, [block size, 1 page by default] --map=map.csv [--algorithms=lz4,zstd,...]"
+               << std::endl;
+  exit(EXIT_FAILURE);
+}
 
-class MemPage {
-  char bytes[kPageSize]{};
+//value of "--name=value" when arg starts with prefix "--name="
+static bool optionValue(const std::string& arg, const char* prefix, std::string& value) {
+  if(arg.rfind(prefix, 0) != 0) {
+    return false;
+  }
+  value = arg.substr(strlen(prefix));
+  return true;
+}
 
- public:
-  MemPage() = default;
+static std::vector<std::string> splitList(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while(std::getline(stream, item, ',')) {
+    if(!item.empty()) {
+      items.push_back(item);
+    }
+  }
+  return items;
+}
 
-  ~MemPage() = default;
+int main(int argc, char* argv[]) {
+  //positional arguments first, "--option[=value]" flags may appear anywhere
+  std::vector<std::string> args;
+  BenchConfig config;
+  std::string baseline;
+  std::string data_dir = "data";
+  std::string output;
+  size_t repeat = 0;//mode default
+  bool shuffle_set = false;
+  bool advise = false;
+  bool profile = false;
+  ProfileConfig profiler;
+  PageMapConfig map;
+  bool swap = false;
+  SwapEmulatorConfig emulator;
+  bool readahead = false;
+  ReadaheadConfig readahead_config;
+  bool thp = false;
+  HugePageConfig huge_page;
+  bool store = false;
+  StoreConfig store_config;
+  bool tiered = false;
+  TieredConfig tiered_config;
+  bool pipeline = false;
+  PipelineConfig pipeline_config;
+  AdvisorConfig advisor;
+  double threshold = 0.05;
+  double ratio_threshold = 0.01;
+  for(int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    std::string value;
+    if(arg == "--verify") {
+      config.verify = true;
+    } else if(arg == "--roofline") {
+      config.roofline = true;
+    } else if(optionValue(arg, "--pid=", value)) {
+      config.pid = std::stoi(value);
+    } else if(optionValue(arg, "--regions=", value)) {
+      config.regions = value;
+    } else if(optionValue(arg, "--limit-mb=", value)) {
+      config.sample_bytes = std::stoul(value) * kMegaByte;
+      emulator.limit_bytes = config.sample_bytes;
+      readahead_config.limit_bytes = config.sample_bytes;
+      huge_page.limit_bytes = config.sample_bytes;
+      store_config.limit_bytes = config.sample_bytes;
+      tiered_config.limit_bytes = config.sample_bytes;
+      pipeline_config.limit_bytes = config.sample_bytes;
+    } else if(arg == "--energy") {
+      config.energy = true;
+    } else if(optionValue(arg, "--level=", value)) {
+      config.level = std::stoi(value);
+    } else if(optionValue(arg, "--shuffle=", value)) {
+      config.shuffle = parseShuffleGranularity(value);
+      shuffle_set = true;
+    } else if(optionValue(arg, "--shuffle-window=", value)) {
+      config.shuffle_window = std::stoul(value);
+    } else if(optionValue(arg, "--layout=", value)) {
+      config.layout = parseBlockLayout(value);
+    } else if(optionValue(arg, "--interleave=", value)) {
+      config.interleave = std::stoul(value);
+    } else if(optionValue(arg, "--page-size=", value)) {
+      config.page_size = std::stoul(value);
+    } else if(optionValue(arg, "--same-fill=", value)) {
+      config.same_fill = std::stoi(value);
+    } else if(optionValue(arg, "--checksum=", value)) {
+      config.checksum = parseChecksumType(value);
+    } else if(optionValue(arg, "--baseline=", value)) {
+      baseline = value;
+    } else if(optionValue(arg, "--data=", value)) {
+      data_dir = value;
+    } else if(optionValue(arg, "--repeat=", value)) {
+      repeat = std::stoul(value);
+    } else if(optionValue(arg, "--threshold=", value)) {
+      threshold = std::stod(value);
+    } else if(optionValue(arg, "--ratio-threshold=", value)) {
+      ratio_threshold = std::stod(value);
+    } else if(optionValue(arg, "--output=", value)) {
+      output = value;
+    } else if(arg == "--advise") {
+      advise = true;
+    } else if(optionValue(arg, "--cpu-budget=", value)) {
+      advisor.cpu_budget = std::stod(value);
+    } else if(optionValue(arg, "--pages-per-second=", value)) {
+      advisor.pages_per_second = std::stod(value);
+    } else if(optionValue(arg, "--fault-ratio=", value)) {
+      advisor.fault_ratio = std::stod(value);
+    } else if(optionValue(arg, "--max-latency-us=", value)) {
+      advisor.max_latency_us = std::stod(value);
+    } else if(optionValue(arg, "--sample-mb=", value)) {
+      advisor.sample_bytes = std::stoul(value) * kMegaByte;
+    } else if(optionValue(arg, "--algorithms=", value)) {
+      advisor.algorithms = splitList(value);
+      profiler.algorithms = advisor.algorithms;
+      map.algorithms = advisor.algorithms;
+      emulator.algorithms = advisor.algorithms;
+      readahead_config.algorithms = advisor.algorithms;
+      huge_page.algorithms = advisor.algorithms;
+    } else if(arg == "--store") {
+      store = true;
+    } else if(optionValue(arg, "--algorithm=", value)) {
+      store_config.algorithm = value;
+      tiered_config.fast_algorithm = value;
+      pipeline_config.algorithm = value;
+    } else if(arg == "--tiered") {
+      tiered = true;
+    } else if(optionValue(arg, "--strong-level=", value)) {
+      tiered_config.strong_level = std::stoi(value);
+    } else if(optionValue(arg, "--cold-ms=", value)) {
+      tiered_config.cold_ms = std::stoull(value);
+    } else if(optionValue(arg, "--trace=", value)) {
+      tiered_config.trace = value;
+    } else if(arg == "--pipeline") {
+      pipeline = true;
+    } else if(optionValue(arg, "--workers=", value)) {
+      for(const std::string& workers : splitList(value)) {
+        pipeline_config.workers.push_back(std::stoul(workers));
+      }
+    } else if(optionValue(arg, "--batch-pages=", value)) {
+      pipeline_config.batch_pages = std::stoul(value);
+    } else if(optionValue(arg, "--ring=", value)) {
+      pipeline_config.ring_batches = std::stoul(value);
+    } else if(optionValue(arg, "--passes=", value)) {
+      pipeline_config.passes = std::stoul(value);
+    } else if(optionValue(arg, "--segment-kb=", value)) {
+      store_config.segment_size = std::stoul(value) * 1024;
+    } else if(optionValue(arg, "--slack=", value)) {
+      store_config.slack = std::stod(value);
+    } else if(optionValue(arg, "--readers=", value)) {
+      store_config.readers = std::stoul(value);
+    } else if(optionValue(arg, "--seconds=", value)) {
+      store_config.seconds = std::stod(value);
+      tiered_config.seconds = store_config.seconds;
+    } else if(optionValue(arg, "--invalidate-ratio=", value)) {
+      store_config.invalidate_ratio = std::stod(value);
+    } else if(arg == "--thp") {
+      thp = true;
+    } else if(optionValue(arg, "--dict-kb=", value)) {
+      huge_page.dict_bytes = std::stoul(value) * 1024;
+    } else if(arg == "--swap") {
+      swap = true;
+    } else if(optionValue(arg, "--resident=", value)) {
+      emulator.resident_fraction = std::stod(value);
+      readahead_config.resident_fraction = emulator.resident_fraction;
+    } else if(optionValue(arg, "--accesses=", value)) {
+      emulator.accesses = std::stoul(value);
+      readahead_config.accesses = emulator.accesses;
+    } else if(optionValue(arg, "--write-ratio=", value)) {
+      emulator.write_ratio = std::stod(value);
+    } else if(arg == "--readahead") {
+      readahead = true;
+    } else if(optionValue(arg, "--max-window=", value)) {
+      readahead_config.max_window = std::stoul(value);
+    } else if(optionValue(arg, "--sequential=", value)) {
+      readahead_config.sequential = std::stod(value);
+    } else if(optionValue(arg, "--map=", value)) {
+      map.output = value;
+    } else if(arg == "--profile") {
+      profile = true;
+    } else if(optionValue(arg, "--sample-pages=", value)) {
+      profiler.sample_pages = std::stoul(value);
+    } else if(optionValue(arg, "--strata=", value)) {
+      profiler.strata = std::stoul(value);
+    } else if(optionValue(arg, "--confidence=", value)) {
+      profiler.confidence = std::stod(value);
+    } else if(optionValue(arg, "--seed=", value)) {
+      profiler.seed = std::stoull(value);
+      readahead_config.seed = profiler.seed;
+    } else if(optionValue(arg, "--levels=", value)) {
+      advisor.levels.clear();
+      for(const std::string& level : splitList(value)) {
+        advisor.levels.push_back(std::stoi(level));
+      }
+    } else if(optionValue(arg, "--blocks=", value)) {
+      advisor.block_pages.clear();
+      for(const std::string& block : splitList(value)) {
+        advisor.block_pages.push_back(std::stoul(block));
+      }
+    } else if(arg.rfind("--", 0) == 0) {
+      std::cerr << "[ERROR]: unknown option " << arg << std::endl;
+      usage();
+    } else {
+      args.push_back(arg);
+    }
+  }
 
-  MemPage(const MemPage& page) { memcpy(bytes, page.bytes, kPageSize); }
+  //detect (and check FASTCOMPRESS_ISA) before any report line is half written
+  cpuFeatures();
+  PinningMap pin;
+  pin.pinning_thread(0, 0, pthread_self());
 
-  MemPage& operator=(const MemPage& page) {
-    memcpy(bytes, page.bytes, kPageSize);
-    return *this;
+  if(!baseline.empty()) {
+    return runRegression(baseline, data_dir, repeat ? repeat : 5, threshold, ratio_threshold, output);
   }
-};
-
-//compressor factory function: algorithm name -> corresponding compressor
-std::unique_ptr<LosslessCompressor> createCompressor(const std::string& algorithm) {
-  if (algorithm == "lz4hc") {
-    return std::make_unique<LZ4HC>();
-  } else if (algorithm == "lz4") {
-    return std::make_unique<LZ4>();
-  } else if (algorithm == "lzo") {
-    return std::make_unique<LZO>();
-  } else if (algorithm == "lzo-rle") {
-    return std::make_unique<LZORLE>();
-  } else if (algorithm == "zstd") {
-    return std::make_unique<ZSTD>();
-  } else if (algorithm == "842") {
-    return std::make_unique<Deflate842>();
-  } else {
-    throw std::invalid_argument("Unknown compression algorithm: " + algorithm);
+
+  if(advise) {
+    if(args.empty()) {
+      usage();
+    }
+    advisor.path = args[0];
+    advisor.repeat = repeat ? repeat : advisor.repeat;
+    return runAdvisor(advisor);
   }
-}
 
-int main(int argc, char* argv[]) {
-  if(argc < 3) {
-    std::cerr << "[USAGE]: file path, block size [n pages], number of iteration,"
-                 " [page random shuffle, false by default]" << std::endl;
-    exit(EXIT_FAILURE);
+  if(profile) {
+    if(args.empty()) {
+      usage();
+    }
+    profiler.path = args[0];
+    return runProfiler(profiler);
   }
 
-  std::string path = std::string(argv[1]);
-  size_t block_size = std::stoul(argv[2]) * kPageSize;
-  size_t niteration = std::stoul(argv[3]);
-  bool page_shuffle = false;
-  page_shuffle = argc >=5 ? std::stoi(argv[4]) : false;//not use page shuffle as defualt
-  std::string algorithm = argc >=6 ? argv[5] : "zstd";//use zstd as default
+  if(swap) {
+    if(args.empty()) {
+      usage();
+    }
+    emulator.path = args[0];
+    return runSwapEmulator(emulator);
+  }
 
-  PinningMap pin;
-  pin.pinning_thread(0, 0, pthread_self());
-  std::cout << "[INFO]: block size " << block_size / kPageSize << " pages, "
-            << "number of iterations " << niteration << std::endl;
-  std::ifstream fin(path);
-  if(!fin.good()) {
-    std::cerr << "[ERROR]: can't open " << path << std::endl;
-    exit(EXIT_FAILURE);
+  if(readahead) {
+    if(args.empty()) {
+      usage();
+    }
+    readahead_config.path = args[0];
+    return runReadahead(readahead_config);
+  }
+
+  if(pipeline) {
+    if(args.empty()) {
+      usage();
+    }
+    pipeline_config.path = args[0];
+    return runPipeline(pipeline_config);
+  }
+
+  if(tiered) {
+    if(args.empty()) {
+      usage();
+    }
+    tiered_config.path = args[0];
+    return runTieredStore(tiered_config);
   }
-  size_t size = std::filesystem::file_size(path);
-  size = size / block_size * block_size;
-  void* origin = aligned_alloc(kPageSize, size);
-  fin.read((char*) origin, size);
-  std::cout << "[INFO]: file size " << size << ", number of blocks " << size / block_size << std::endl;
-
-  if(page_shuffle) {
-    std::mt19937 generator(std::random_device{}());
-    std::shuffle((MemPage*) origin, (MemPage*) ((uintptr_t) origin + size - kPageSize), generator);
+
+  if(store) {
+    if(args.empty()) {
+      usage();
+    }
+    store_config.path = args[0];
+    return runStore(store_config);
   }
 
-//  LosslessCompressor* compressor = new ZSTD();
-//  LosslessCompressor* compressor = new LZ4();
-
-  //use factory function to choose commpressor based on input
-  std::unique_ptr<LosslessCompressor> compressor = createCompressor(algorithm);
-
-  size_t comp_block_size = block_size * 2;
-  void* compressed = aligned_alloc(kPageSize, comp_block_size * size / block_size);
-  size_t* compressed_size = (size_t*) calloc(size / block_size, sizeof(size_t));
-  size_t nblock = size / block_size;
-  size_t total_compressed = 0;
-  Timer timer;
-  timer.start();
-
-  //double loop compression
-  for(size_t i = 0; i < niteration; i++) {//first loop: compression level
-    for(size_t bid = 0; bid < nblock; bid++) {//second loop: compress each block
-      void* dst = (char*) compressed + bid * comp_block_size;
-      void* src = (char*) origin + bid * block_size;
-      size_t res = compressor->compress(dst, comp_block_size, src, block_size);
-      total_compressed += res;
-      compressed_size[bid] = res;
+  if(thp) {
+    if(args.empty()) {
+      usage();
     }
+    huge_page.path = args[0];
+    return runHugePage(huge_page);
   }
-  long drt = timer.duration_us();
-
-  double tpt = double(size * niteration) / kMegaByte / drt * 1000000ul;
-  double ratio = double(size * niteration) / total_compressed;
-  std::cout << "[INFO]: compression throughput " << tpt << " MiB/Second" << std::endl;
-  std::cout << "[INFO]: compression ratio (original size / compressed size) " << ratio
-            << ", compressed size / original size " << 1 / ratio << std::endl;
-
-  timer.start();
-
-  //double loop decompression
-  for(size_t i = 0; i < niteration; i++) {
-    for(size_t bid = 0; bid < nblock; bid++) {
-      void* src = (char*) compressed + bid * comp_block_size;
-      void* dst = (char*) origin + bid * block_size;
-      compressor->decompress(dst, block_size, src, compressed_size[bid]);
+
+  if(!map.output.empty()) {
+    if(args.empty()) {
+      usage();
     }
+    map.path = args[0];
+    map.block_pages = args.size() >= 2 ? std::stoul(args[1]) : 1;
+    return runPageMap(map);
+  }
+
+  //a captured process replaces the file path, the other positional arguments stay the same
+  size_t first = config.pid ? 0 : 1;
+  if(args.size() < first + 2) {
+    usage();
   }
-  drt = timer.duration_us();
-  tpt = double(size * niteration) / kMegaByte / drt * 1000000ul;
-  std::cout << "[INFO]: decompression throughput " << tpt << " MiB/Second" << std::endl;
 
-  free(compressed_size);
-  free(compressed);
-  free(origin);
+  config.path = config.pid ? "pid " + std::to_string(config.pid) : args[0];
+  config.block_pages = std::stoul(args[first]);
+  config.niteration = std::stoul(args[first + 1]);
+  config.page_shuffle = args.size() >= first + 3 ? std::stoi(args[first + 2]) : shuffle_set;//not use page shuffle as defualt
+  config.algorithm = args.size() >= first + 4 ? args[first + 3] : "zstd";//use zstd as default
 
-  return 0;
-}
\ No newline at end of file
+  BenchResult result = runBenchmark(config);
+  return result.failed ? EXIT_FAILURE : 0;
+}
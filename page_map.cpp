@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include "compress.h"
+#include "page_scan.h"
+#include "benchmark.h"
+
+using namespace FastCompress;
+
+//zsmalloc size classes of 4 KiB pages: 32 bytes minimum, 16 byte steps up to a full page
+static constexpr size_t kZsMinAlloc = 32;
+static constexpr size_t kZsClassDelta = kPageSize >> 8;
+static constexpr size_t kZsClasses = (kPageSize - kZsMinAlloc) / kZsClassDelta + 1;
+
+namespace {
+
+//smallest size class holding size bytes, zram stores anything beyond a page uncompressed
+size_t zsClass(size_t size) {
+  if(size <= kZsMinAlloc) {
+    return 0;
+  }
+  return std::min((size - kZsMinAlloc + kZsClassDelta - 1) / kZsClassDelta, kZsClasses - 1);
+}
+
+size_t zsClassSize(size_t index) {
+  return kZsMinAlloc + index * kZsClassDelta;
+}
+
+//shannon entropy of the byte distribution, bits per byte
+double byteEntropy(const unsigned char* data, size_t len) {
+  size_t count[256] = {};
+  for(size_t i = 0; i < len; i++) {
+    count[data[i]]++;
+  }
+  double entropy = 0;
+  for(size_t c : count) {
+    if(c) {
+      double p = double(c) / len;
+      entropy -= p * std::log2(p);
+    }
+  }
+  return entropy;
+}
+
+const char* className(PageClass page_class) {
+  switch(page_class) {
+    case PageClass::Zero:
+      return "zero";
+    case PageClass::SameFilled:
+      return "same";
+    default:
+      return "mixed";
+  }
+}
+
+}
+
+int runPageMap(const PageMapConfig& map) {
+  std::ifstream fin(map.path);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << map.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t block_size = map.block_pages * kPageSize;
+  size_t size = std::filesystem::file_size(map.path) / block_size * block_size;
+  size_t nblock = size / block_size;
+  char* origin = (char*) aligned_alloc(kPageSize, std::max(size, kPageSize));
+  fin.read(origin, size);
+
+  std::vector<PageClass> classes(nblock);
+  std::vector<double> entropy(nblock);
+  for(size_t bid = 0; bid < nblock; bid++) {
+    uint64_t pattern;
+    classes[bid] = classifyPage(origin + bid * block_size, block_size, &pattern);
+    entropy[bid] = byteEntropy((unsigned char*) origin + bid * block_size, block_size);
+  }
+
+  //raw compressors: zero and same-filled blocks are flagged by the class column instead
+  std::vector<std::vector<size_t>> compressed_size(map.algorithms.size(), std::vector<size_t>(nblock));
+  char* compressed = (char*) aligned_alloc(kPageSize, 2 * block_size);
+  for(size_t a = 0; a < map.algorithms.size(); a++) {
+    std::unique_ptr<LosslessCompressor> compressor = createCompressor(map.algorithms[a], false);
+    for(size_t bid = 0; bid < nblock; bid++) {
+      compressed_size[a][bid] = compressor->compress(compressed, 2 * block_size, origin + bid * block_size, block_size);
+    }
+  }
+  free(compressed);
+  free(origin);
+
+  std::ofstream fout(map.output);
+  if(!fout.good()) {
+    std::cerr << "[ERROR]: can't write " << map.output << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  fout << "block,class,entropy";
+  for(const std::string& algorithm : map.algorithms) {
+    fout << "," << algorithm;
+  }
+  fout << std::endl;
+  for(size_t bid = 0; bid < nblock; bid++) {
+    char entropy_text[16];
+    snprintf(entropy_text, sizeof(entropy_text), "%.3f", entropy[bid]);
+    fout << bid << "," << className(classes[bid]) << "," << entropy_text;
+    for(size_t a = 0; a < map.algorithms.size(); a++) {
+      fout << "," << compressed_size[a][bid];
+    }
+    fout << "\n";
+  }
+  std::cout << "[INFO]: compressibility map of " << nblock << " blocks of " << map.block_pages
+            << " pages written to " << map.output << std::endl;
+
+  size_t filled = std::count_if(classes.begin(), classes.end(), [](PageClass c) { return c != PageClass::Mixed; });
+  std::cout << "[INFO]: zero/same-filled blocks " << filled << ", mixed blocks " << nblock - filled << std::endl;
+  if(map.block_pages != 1) {
+    std::cout << "[INFO]: zsmalloc size-class histogram needs single-page blocks, skipped" << std::endl;
+    return 0;
+  }
+
+  //size-class histogram of the mixed pages, the ones that occupy zsmalloc objects
+  std::filesystem::path histogram_path = map.output;
+  histogram_path.replace_filename(histogram_path.stem().string() + "_classes.csv");
+  std::vector<std::vector<size_t>> histogram(map.algorithms.size(), std::vector<size_t>(kZsClasses));
+  for(size_t a = 0; a < map.algorithms.size(); a++) {
+    std::vector<size_t> sizes;
+    size_t pool = 0;
+    for(size_t bid = 0; bid < nblock; bid++) {
+      if(classes[bid] == PageClass::Mixed) {
+        size_t index = zsClass(compressed_size[a][bid]);
+        histogram[a][index]++;
+        pool += zsClassSize(index);
+        sizes.push_back(compressed_size[a][bid]);
+      }
+    }
+    std::sort(sizes.begin(), sizes.end());
+    if(sizes.empty()) {
+      continue;
+    }
+    std::cout << "[INFO]: " << map.algorithms[a] << " compressed size p50 " << sizes[sizes.size() / 2]
+              << ", p90 " << sizes[sizes.size() * 9 / 10] << ", p99 " << sizes[sizes.size() * 99 / 100]
+              << " bytes, class-rounded pool " << double(pool) / kMegaByte << " MiB for "
+              << double(sizes.size() * kPageSize) / kMegaByte << " MiB of pages" << std::endl;
+  }
+  std::ofstream hout(histogram_path);
+  hout << "class_size";
+  for(const std::string& algorithm : map.algorithms) {
+    hout << "," << algorithm;
+  }
+  hout << std::endl;
+  for(size_t index = 0; index < kZsClasses; index++) {
+    hout << zsClassSize(index);
+    for(size_t a = 0; a < map.algorithms.size(); a++) {
+      hout << "," << histogram[a][index];
+    }
+    hout << "\n";
+  }
+  std::cout << "[INFO]: zsmalloc size-class histogram written to " << histogram_path.string() << std::endl;
+  return 0;
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_PAGE_SCAN_H
+#define FASTCOMPRESS_PAGE_SCAN_H
+
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "cpu_features.h"
+
+namespace FastCompress {
+
+/**
+ * @brief content class of a page, zero and same-filled pages are stored as a pattern only
+ * */
+enum class PageClass {
+  Zero,
+  SameFilled,
+  Mixed,
+};
+
+//page classify kernel: page content, page length, repeated 64-bit pattern if not mixed -> class
+using PageClassifyFn = PageClass (*)(const void* data, size_t len, uint64_t* pattern);
+//page fill kernel: destination, length (multiple of 8), 64-bit pattern
+using PageFillFn = void (*)(void* dst, size_t len, uint64_t pattern);
+
+namespace detail {
+
+inline uint64_t loadPattern(const void* data) {
+  uint64_t pattern;
+  memcpy(&pattern, data, sizeof(pattern));
+  return pattern;
+}
+
+//scalar tail shared by the vector classifiers, compares the remaining words with pattern
+inline PageClass classifyTail(const unsigned char* p, size_t len, uint64_t pattern, uint64_t* out_pattern) {
+  for(; len >= 8; len -= 8, p += 8) {
+    if(loadPattern(p) != pattern) {
+      return PageClass::Mixed;
+    }
+  }
+  *out_pattern = pattern;
+  return pattern == 0 ? PageClass::Zero : PageClass::SameFilled;
+}
+
+inline PageClass classifyScalar(const void* data, size_t len, uint64_t* pattern) {
+  if(len < 8 || len % 8 != 0) {
+    return PageClass::Mixed;
+  }
+  return classifyTail((const unsigned char*)data, len, loadPattern(data), pattern);
+}
+
+inline void fillScalar(void* dst, size_t len, uint64_t pattern) {
+  if(pattern == (pattern & 0xff) * 0x0101010101010101ull) {
+    memset(dst, (int)(pattern & 0xff), len);
+    return;
+  }
+  unsigned char* p = (unsigned char*)dst;
+  for(size_t i = 0; i < len; i += 8) {
+    memcpy(p + i, &pattern, sizeof(pattern));
+  }
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief vector classifiers xor each chunk with the broadcast first word and exit on the
+ * first chunk that differs, so a mixed page usually costs a single chunk
+ * */
+__attribute__((target("avx2")))
+inline PageClass classifyAvx2(const void* data, size_t len, uint64_t* pattern) {
+  if(len < 8 || len % 8 != 0) {
+    return PageClass::Mixed;
+  }
+  const unsigned char* p = (const unsigned char*)data;
+  uint64_t first = loadPattern(p);
+  __m256i broadcast = _mm256_set1_epi64x((long long)first);
+  for(; len >= 128; len -= 128, p += 128) {
+    __m256i diff = _mm256_or_si256(
+        _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)p), broadcast),
+                        _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + 32)), broadcast)),
+        _mm256_or_si256(_mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + 64)), broadcast),
+                        _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(p + 96)), broadcast)));
+    if(!_mm256_testz_si256(diff, diff)) {
+      return PageClass::Mixed;
+    }
+  }
+  return classifyTail(p, len, first, pattern);
+}
+
+__attribute__((target("avx512f")))
+inline PageClass classifyAvx512(const void* data, size_t len, uint64_t* pattern) {
+  if(len < 8 || len % 8 != 0) {
+    return PageClass::Mixed;
+  }
+  const unsigned char* p = (const unsigned char*)data;
+  uint64_t first = loadPattern(p);
+  __m512i broadcast = _mm512_set1_epi64((long long)first);
+  for(; len >= 256; len -= 256, p += 256) {
+    //0xf6: a | (b ^ c), two ternary ops fold the four chunk compares
+    __m512i diff01 = _mm512_ternarylogic_epi64(_mm512_xor_si512(_mm512_loadu_si512(p), broadcast),
+                                               _mm512_loadu_si512(p + 64), broadcast, 0xf6);
+    __m512i diff23 = _mm512_ternarylogic_epi64(_mm512_xor_si512(_mm512_loadu_si512(p + 128), broadcast),
+                                               _mm512_loadu_si512(p + 192), broadcast, 0xf6);
+    if(_mm512_test_epi64_mask(diff01, diff01) | _mm512_test_epi64_mask(diff23, diff23)) {
+      return PageClass::Mixed;
+    }
+  }
+  return classifyTail(p, len, first, pattern);
+}
+
+/**
+ * @brief non-temporal fill: a restored same-filled page is not read back soon, so bypass the
+ * cache instead of evicting useful lines; unaligned destinations fall back to plain stores
+ * */
+__attribute__((target("avx2")))
+inline void fillAvx2(void* dst, size_t len, uint64_t pattern) {
+  if((uintptr_t)dst % 32 != 0 || len % 128 != 0) {
+    fillScalar(dst, len, pattern);
+    return;
+  }
+  __m256i broadcast = _mm256_set1_epi64x((long long)pattern);
+  unsigned char* p = (unsigned char*)dst;
+  for(size_t i = 0; i < len; i += 128) {
+    _mm256_stream_si256((__m256i*)(p + i), broadcast);
+    _mm256_stream_si256((__m256i*)(p + i + 32), broadcast);
+    _mm256_stream_si256((__m256i*)(p + i + 64), broadcast);
+    _mm256_stream_si256((__m256i*)(p + i + 96), broadcast);
+  }
+  _mm_sfence();
+}
+
+__attribute__((target("avx512f")))
+inline void fillAvx512(void* dst, size_t len, uint64_t pattern) {
+  if((uintptr_t)dst % 64 != 0 || len % 256 != 0) {
+    fillScalar(dst, len, pattern);
+    return;
+  }
+  __m512i broadcast = _mm512_set1_epi64((long long)pattern);
+  unsigned char* p = (unsigned char*)dst;
+  for(size_t i = 0; i < len; i += 256) {
+    _mm512_stream_si512((__m512i*)(p + i), broadcast);
+    _mm512_stream_si512((__m512i*)(p + i + 64), broadcast);
+    _mm512_stream_si512((__m512i*)(p + i + 128), broadcast);
+    _mm512_stream_si512((__m512i*)(p + i + 192), broadcast);
+  }
+  _mm_sfence();
+}
+#endif
+
+}
+
+/**
+ * @brief page classifier implementations, ordered slowest first
+ * */
+inline const std::vector<DispatchKernel<PageClassifyFn>>& classifyKernels() {
+  static const std::vector<DispatchKernel<PageClassifyFn>> kernels = {
+    {"scalar", anyCpu, detail::classifyScalar},
+#if defined(__x86_64__)
+    {"avx2", hasAvx2, detail::classifyAvx2},
+    {"avx512", hasAvx512f, detail::classifyAvx512},
+#endif
+  };
+  return kernels;
+}
+
+/**
+ * @brief page fill implementations, ordered slowest first
+ * */
+inline const std::vector<DispatchKernel<PageFillFn>>& fillKernels() {
+  static const std::vector<DispatchKernel<PageFillFn>> kernels = {
+    {"memset", anyCpu, detail::fillScalar},
+#if defined(__x86_64__)
+    {"avx2-nt", hasAvx2, detail::fillAvx2},
+    {"avx512-nt", hasAvx512f, detail::fillAvx512},
+#endif
+  };
+  return kernels;
+}
+
+/**
+ * @brief classify a page as zero, same-filled with a 64-bit pattern, or mixed in one pass
+ * @param data the page content
+ * @param len the length of page, pages not a multiple of 8 bytes are always mixed
+ * @param pattern receives the repeated 64-bit word unless the page is mixed
+ * */
+inline PageClass classifyPage(const void* data, size_t len, uint64_t* pattern) {
+  static const PageClassifyFn fn = selectKernel(classifyKernels()).fn;
+  return fn(data, len, pattern);
+}
+
+/**
+ * @brief restore a zero or same-filled page from its 64-bit pattern
+ * @param dst the page to fill
+ * @param len the length of page, a multiple of 8
+ * @param pattern the repeated 64-bit word
+ * */
+inline void fillPage(void* dst, size_t len, uint64_t pattern) {
+  static const PageFillFn fn = selectKernel(fillKernels()).fn;
+  fn(dst, len, pattern);
+}
+
+}
+
+#endif //FASTCOMPRESS_PAGE_SCAN_H
@@ -0,0 +1,333 @@
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+#include "checksum.h"
+#include "compress.h"
+#include "log_store.h"
+#include "page_scan.h"
+#include "spsc_ring.h"
+#include "benchmark.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+//first byte of every stored record
+enum RecordKind : char {
+  kCompressed = 0,
+  kSameFilled = 1,//8-byte pattern follows
+  kDuplicate = 2,//8-byte id of the page holding the same content follows
+  kRaw = 3,//compression did not shrink the page
+};
+
+namespace {
+
+struct Batch {
+  size_t first_page = 0;
+  size_t npages = 0;
+  std::vector<PageClass> classes;
+  std::vector<uint64_t> patterns;
+  std::vector<size_t> duplicate_of;//SIZE_MAX unless a duplicate
+  std::vector<char> records;//one 2 * page + 1 slot per page
+  std::vector<size_t> lengths;
+
+  explicit Batch(size_t batch_pages)
+      : classes(batch_pages), patterns(batch_pages), duplicate_of(batch_pages),
+        records(batch_pages * (2 * kPageSize + 1)), lengths(batch_pages) {}
+
+  char* record(size_t i) { return records.data() + i * (2 * kPageSize + 1); }
+};
+
+//time a stage spent working and waiting on its neighbours
+struct StageTime {
+  long busy_ns = 0;
+  long starved_ns = 0;//input ring empty
+  long blocked_ns = 0;//output ring full
+};
+
+template<typename T>
+void pushWait(SpscRing<T>& ring, const T& value, long& waited_ns) {
+  if(ring.push(value)) {
+    return;
+  }
+  Timer timer;
+  timer.start();
+  while(!ring.push(value)) {
+    std::this_thread::yield();
+  }
+  waited_ns += timer.duration_ns();
+}
+
+template<typename T>
+T popWait(SpscRing<T>& ring, long& waited_ns) {
+  T value;
+  if(ring.pop(value)) {
+    return value;
+  }
+  Timer timer;
+  timer.start();
+  while(!ring.pop(value)) {
+    std::this_thread::yield();
+  }
+  waited_ns += timer.duration_ns();
+  return value;
+}
+
+double percent(long part_ns, long wall_ns) { return wall_ns > 0 ? 100.0 * part_ns / wall_ns : 0; }
+
+}
+
+int runPipeline(const PipelineConfig& pipeline) {
+  std::ifstream fin(pipeline.path);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << pipeline.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t size = std::filesystem::file_size(pipeline.path);
+  if(pipeline.limit_bytes) {
+    size = std::min(size, pipeline.limit_bytes);
+  }
+  size_t npages = size / kPageSize;
+  size = npages * kPageSize;
+  if(npages == 0 || pipeline.batch_pages == 0) {
+    std::cerr << "[ERROR]: nothing to compress in " << pipeline.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  char* origin = (char*) aligned_alloc(kPageSize, size);
+  fin.read(origin, size);
+
+  std::vector<size_t> worker_counts = pipeline.workers;
+  if(worker_counts.empty()) {
+    for(size_t n = 1; n <= std::max(1u, std::thread::hardware_concurrency()); n <<= 1) {
+      worker_counts.push_back(n);
+    }
+  }
+  std::cout << "[INFO]: pipeline " << pipeline.path << ", " << npages << " pages, " << pipeline.algorithm << ", batches of "
+            << pipeline.batch_pages << " pages, rings of " << pipeline.ring_batches << " batches, " << pipeline.passes
+            << " passes" << std::endl;
+
+  int status = 0;
+  for(size_t nworker : worker_counts) {
+    //every page may be rewritten once before compaction catches up
+    size_t segment_size = 128 * 1024;
+    LogStore store(npages, segment_size, 2 * (size + npages * 32) / segment_size + 8);
+
+    //batches circulate producer -> compressor i -> committer -> producer
+    size_t nbatch = (2 * nworker + 1) * pipeline.ring_batches;
+    std::vector<std::unique_ptr<Batch>> pool;
+    SpscRing<Batch*> free_ring(nbatch);
+    for(size_t b = 0; b < nbatch; b++) {
+      pool.push_back(std::make_unique<Batch>(pipeline.batch_pages));
+      free_ring.push(pool.back().get());
+    }
+    std::vector<std::unique_ptr<SpscRing<Batch*>>> to_worker, to_commit;
+    for(size_t w = 0; w < nworker; w++) {
+      to_worker.push_back(std::make_unique<SpscRing<Batch*>>(pipeline.ring_batches));
+      to_commit.push_back(std::make_unique<SpscRing<Batch*>>(pipeline.ring_batches));
+    }
+
+    StageTime produce_time, commit_time;
+    std::vector<StageTime> compress_time(nworker);
+    size_t same_filled = 0, duplicates = 0;
+    size_t stored_bytes = 0;
+    Timer wall;
+    wall.start();
+
+    //produce: classify zero/same-filled pages and look up duplicates by content hash
+    std::thread producer([&]() {
+      std::unordered_map<uint64_t, size_t> seen;
+      size_t next_worker = 0;
+      Timer timer;
+      for(size_t pass = 0; pass < pipeline.passes; pass++) {
+        seen.clear();
+        for(size_t first = 0; first < npages; first += pipeline.batch_pages) {
+          Batch* batch = popWait(free_ring, produce_time.starved_ns);
+          timer.start();
+          batch->first_page = first;
+          batch->npages = std::min(pipeline.batch_pages, npages - first);
+          for(size_t i = 0; i < batch->npages; i++) {
+            const char* page = origin + (first + i) * kPageSize;
+            batch->duplicate_of[i] = SIZE_MAX;
+            batch->classes[i] = classifyPage(page, kPageSize, &batch->patterns[i]);
+            if(batch->classes[i] != PageClass::Mixed) {
+              continue;
+            }
+            auto [it, inserted] = seen.emplace(xxh3(page, kPageSize), first + i);
+            if(!inserted && memcmp(origin + it->second * kPageSize, page, kPageSize) == 0) {
+              batch->duplicate_of[i] = it->second;
+            }
+          }
+          produce_time.busy_ns += timer.duration_ns();
+          //the first compressor with room, so one slow worker does not stall the others
+          while(!to_worker[next_worker]->push(batch)) {
+            next_worker = (next_worker + 1) % nworker;
+            timer.start();
+            std::this_thread::yield();
+            produce_time.blocked_ns += timer.duration_ns();
+          }
+          next_worker = (next_worker + 1) % nworker;
+        }
+      }
+      for(size_t w = 0; w < nworker; w++) {
+        pushWait(*to_worker[w], (Batch*) nullptr, produce_time.blocked_ns);
+      }
+    });
+
+    //compress: encode the records of mixed, not duplicated pages
+    std::vector<std::thread> workers;
+    for(size_t w = 0; w < nworker; w++) {
+      workers.emplace_back([&, w]() {
+        std::unique_ptr<LosslessCompressor> compressor = createCompressor(pipeline.algorithm, false);
+        StageTime& time = compress_time[w];
+        Timer timer;
+        while(Batch* batch = popWait(*to_worker[w], time.starved_ns)) {
+          timer.start();
+          for(size_t i = 0; i < batch->npages; i++) {
+            char* record = batch->record(i);
+            const char* page = origin + (batch->first_page + i) * kPageSize;
+            if(batch->classes[i] != PageClass::Mixed) {
+              record[0] = kSameFilled;
+              memcpy(record + 1, &batch->patterns[i], sizeof(uint64_t));
+              batch->lengths[i] = 1 + sizeof(uint64_t);
+            } else if(batch->duplicate_of[i] != SIZE_MAX) {
+              record[0] = kDuplicate;
+              uint64_t target = batch->duplicate_of[i];
+              memcpy(record + 1, &target, sizeof(uint64_t));
+              batch->lengths[i] = 1 + sizeof(uint64_t);
+            } else {
+              size_t res = compressor->compress(record + 1, 2 * kPageSize, (void*) page, kPageSize);
+              if(res == 0 || res >= kPageSize) {
+                record[0] = kRaw;
+                memcpy(record + 1, page, kPageSize);
+                res = kPageSize;
+              } else {
+                record[0] = kCompressed;
+              }
+              batch->lengths[i] = 1 + res;
+            }
+          }
+          time.busy_ns += timer.duration_ns();
+          pushWait(*to_commit[w], batch, time.blocked_ns);
+        }
+        pushWait(*to_commit[w], (Batch*) nullptr, time.blocked_ns);
+      });
+    }
+
+    //commit: append every record to the store and hand the batch back to the producer
+    std::thread committer([&]() {
+      size_t finished = 0;
+      std::vector<bool> drained(nworker, false);
+      size_t w = 0;
+      Timer timer;
+      timer.start();
+      bool idle = false;//timer measures the current wait
+      while(finished < nworker) {
+        Batch* batch;
+        if(drained[w] || !to_commit[w]->pop(batch)) {
+          if(!idle) {
+            idle = true;
+            timer.start();
+          }
+          w = (w + 1) % nworker;
+          if(w == 0) {
+            std::this_thread::yield();
+          }
+          continue;
+        }
+        if(idle) {
+          commit_time.starved_ns += timer.duration_ns();
+          idle = false;
+        }
+        if(batch == nullptr) {
+          finished++;
+          drained[w] = true;
+          continue;
+        }
+        timer.start();
+        for(size_t i = 0; i < batch->npages; i++) {
+          char kind = batch->record(i)[0];
+          same_filled += kind == kSameFilled;
+          duplicates += kind == kDuplicate;
+          stored_bytes += batch->lengths[i];
+          store.put(batch->first_page + i, batch->record(i), batch->lengths[i]);
+        }
+        commit_time.busy_ns += timer.duration_ns();
+        pushWait(free_ring, batch, commit_time.blocked_ns);
+      }
+    });
+
+    producer.join();
+    for(std::thread& worker : workers) {
+      worker.join();
+    }
+    committer.join();
+    long wall_ns = wall.duration_ns();
+
+    //read everything back from the store
+    std::unique_ptr<LosslessCompressor> decompressor = createCompressor(pipeline.algorithm, false);
+    char* page = (char*) aligned_alloc(kPageSize, kPageSize);
+    size_t mismatches = 0;
+    for(size_t pid = 0; pid < npages; pid++) {
+      size_t source = pid;
+      bool found = store.read(pid, [&](const char* data, size_t len) {
+        uint64_t word;
+        switch(data[0]) {
+          case kSameFilled:
+            memcpy(&word, data + 1, sizeof(uint64_t));
+            fillPage(page, kPageSize, word);
+            break;
+          case kDuplicate:
+            memcpy(&word, data + 1, sizeof(uint64_t));
+            source = word;
+            break;
+          case kRaw:
+            memcpy(page, data + 1, kPageSize);
+            break;
+          default:
+            decompressor->decompress(page, kPageSize, (void*) (data + 1), len - 1);
+        }
+      });
+      if(found && source != pid) {
+        //a duplicate resolves to the first page with its content
+        found = store.read(source, [&](const char* data, size_t len) {
+          data[0] == kRaw ? (void) memcpy(page, data + 1, kPageSize)
+                          : (void) decompressor->decompress(page, kPageSize, (void*) (data + 1), len - 1);
+        });
+      }
+      mismatches += !found || memcmp(page, origin + pid * kPageSize, kPageSize) != 0;
+    }
+    free(page);
+
+    StageTime compress_total;
+    for(const StageTime& time : compress_time) {
+      compress_total.busy_ns += time.busy_ns / nworker;
+      compress_total.starved_ns += time.starved_ns / nworker;
+      compress_total.blocked_ns += time.blocked_ns / nworker;
+    }
+    double produce_busy = percent(produce_time.busy_ns, wall_ns);
+    double compress_busy = percent(compress_total.busy_ns, wall_ns);
+    double commit_busy = percent(commit_time.busy_ns, wall_ns);
+    const char* bottleneck = produce_busy >= compress_busy && produce_busy >= commit_busy ? "produce"
+                             : compress_busy >= commit_busy ? "compress" : "commit";
+    double processed = double(size) * pipeline.passes;
+    std::cout << "[INFO]: " << nworker << " compress threads: " << processed / kMegaByte / (wall_ns / 1e9)
+              << " MiB/s, ratio " << processed / std::max<size_t>(stored_bytes, 1) << ", " << same_filled
+              << " same-filled and " << duplicates << " duplicate pages, bottleneck " << bottleneck << std::endl;
+    std::cout << "[INFO]:   produce busy " << produce_busy << "% (starved " << percent(produce_time.starved_ns, wall_ns)
+              << "%, blocked " << percent(produce_time.blocked_ns, wall_ns) << "%), compress busy " << compress_busy
+              << "% per thread (starved " << percent(compress_total.starved_ns, wall_ns) << "%, blocked "
+              << percent(compress_total.blocked_ns, wall_ns) << "%), commit busy " << commit_busy << "% (starved "
+              << percent(commit_time.starved_ns, wall_ns) << "%, blocked " << percent(commit_time.blocked_ns, wall_ns)
+              << "%)" << std::endl;
+    if(mismatches) {
+      std::cout << "[ERROR]: " << mismatches << " pages read back wrong from the store" << std::endl;
+      status = EXIT_FAILURE;
+    }
+  }
+  free(origin);
+  return status;
+}
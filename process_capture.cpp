@@ -0,0 +1,146 @@
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "benchmark.h"
+
+//pagemap entry bits: page present in ram, page swapped out
+static constexpr uint64_t kPagemapPresent = 1ull << 63;
+static constexpr uint64_t kPagemapSwapped = 1ull << 62;
+//pages per process_vm_readv call
+static constexpr size_t kCaptureChunkPages = 256;
+
+//maps and pagemap describe host pages
+static const size_t kCapturePage = sysconf(_SC_PAGESIZE);
+
+namespace {
+
+struct Region {
+  uintptr_t start;
+  uintptr_t end;
+};
+
+//kind of a mapping as the --regions filter names it, empty for file-backed and kernel mappings
+std::string regionKind(const std::string& inode, const std::string& name) {
+  if(name == "[heap]") {
+    return "heap";
+  }
+  if(name.rfind("[stack", 0) == 0) {
+    return "stack";
+  }
+  if(inode == "0" && (name.empty() || name.rfind("[anon", 0) == 0)) {
+    return "anon";
+  }
+  return "";
+}
+
+std::vector<Region> readableRegions(pid_t pid, const std::string& regions) {
+  std::string maps_path = "/proc/" + std::to_string(pid) + "/maps";
+  std::ifstream maps(maps_path);
+  if(!maps.good()) {
+    std::cerr << "[ERROR]: can't open " << maps_path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::vector<Region> result;
+  std::string line;
+  while(std::getline(maps, line)) {
+    //start-end perms offset dev inode [name]
+    std::istringstream fields(line);
+    std::string range, perms, offset, dev, inode, name;
+    fields >> range >> perms >> offset >> dev >> inode;
+    std::getline(fields >> std::ws, name);
+    std::string kind = regionKind(inode, name);
+    if(perms[0] != 'r' || kind.empty() || ("," + regions + ",").find("," + kind + ",") == std::string::npos) {
+      continue;
+    }
+    size_t dash = range.find('-');
+    result.push_back({std::stoull(range.substr(0, dash), nullptr, 16), std::stoull(range.substr(dash + 1), nullptr, 16)});
+  }
+  return result;
+}
+
+}
+
+void* captureProcess(pid_t pid, const std::string& regions, size_t limit, size_t& size) {
+  std::vector<Region> mappings = readableRegions(pid, regions);
+  //pagemap tells which pages were ever touched, the others would read back as the zero page
+  //and are not memory a swap device would ever see
+  int pagemap = open(("/proc/" + std::to_string(pid) + "/pagemap").c_str(), O_RDONLY);
+  int mem = -1;
+
+  size_t npages = 0;
+  for(const Region& region : mappings) {
+    npages += (region.end - region.start) / kCapturePage;
+  }
+  if(limit) {
+    npages = std::min(npages, limit / kCapturePage);
+  }
+  char* buffer = (char*) aligned_alloc(kCapturePage, std::max<size_t>(npages, 1) * kCapturePage);
+  size_t captured = 0;
+  size_t skipped = 0;
+  std::vector<uint64_t> entries(kCaptureChunkPages);
+  std::vector<struct iovec> local(kCaptureChunkPages), remote(kCaptureChunkPages);
+  //one page by process_vm_readv, or /proc/<pid>/mem where that is blocked (or the other way round)
+  auto readPage = [&](char* dst, uintptr_t addr) {
+    struct iovec local_page = {dst, kCapturePage};
+    struct iovec remote_page = {(void*) addr, kCapturePage};
+    if(process_vm_readv(pid, &local_page, 1, &remote_page, 1, 0) == ssize_t(kCapturePage)) {
+      return true;
+    }
+    if(mem < 0) {
+      mem = open(("/proc/" + std::to_string(pid) + "/mem").c_str(), O_RDONLY);
+    }
+    return mem >= 0 && pread(mem, dst, kCapturePage, off_t(addr)) == ssize_t(kCapturePage);
+  };
+  for(const Region& region : mappings) {
+    for(uintptr_t addr = region.start; addr < region.end && captured < npages;) {
+      size_t count = std::min<size_t>({kCaptureChunkPages, (region.end - addr) / kCapturePage, npages - captured});
+      bool pagemap_ok = pagemap >= 0 && pread(pagemap, entries.data(), count * sizeof(uint64_t),
+                                              off_t(addr / kCapturePage * sizeof(uint64_t))) == ssize_t(count * sizeof(uint64_t));
+      //the touched pages of the chunk land in consecutive buffer pages, one syscall for all of them
+      size_t ntouched = 0;
+      for(size_t i = 0; i < count; i++) {
+        if(pagemap_ok && !(entries[i] & (kPagemapPresent | kPagemapSwapped))) {
+          skipped++;
+          continue;
+        }
+        local[ntouched] = {buffer + (captured + ntouched) * kCapturePage, kCapturePage};
+        remote[ntouched] = {(void*) (addr + i * kCapturePage), kCapturePage};
+        ntouched++;
+      }
+      ssize_t res = ntouched ? process_vm_readv(pid, local.data(), ntouched, remote.data(), ntouched, 0) : 0;
+      //a partial transfer stops at a whole iovec, the pages from there on are read one by one
+      size_t done = res > 0 ? size_t(res) / kCapturePage : 0;
+      captured += done;
+      for(size_t t = done; t < ntouched; t++) {
+        if(readPage(buffer + captured * kCapturePage, (uintptr_t) remote[t].iov_base)) {
+          captured++;
+        } else {
+          skipped++;//unmapped in the meantime or guard page
+        }
+      }
+      addr += count * kCapturePage;
+    }
+  }
+  if(mem >= 0) {
+    close(mem);
+  }
+  if(pagemap >= 0) {
+    close(pagemap);
+  }
+  if(captured == 0) {
+    std::cerr << "[ERROR]: captured no page of pid " << pid << " (" << regions
+              << "), check ptrace permission" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::cout << "[INFO]: captured " << captured << " pages of pid " << pid << " from " << mappings.size()
+            << " " << regions << " mappings, skipped " << skipped << " untouched or unreadable pages" << std::endl;
+  size = captured * kCapturePage;
+  return buffer;
+}
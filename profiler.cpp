@@ -0,0 +1,162 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <unordered_set>
+#include "compress.h"
+#include "benchmark.h"
+#include "stats.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+namespace {
+
+/**
+ * @brief stratified estimate of the per-page mean of one measurement: the file is cut into
+ * equally sized strata and every stratum contributes its own sample mean and variance
+ * */
+struct StratifiedMean {
+  double mean = 0;
+  double half_width = 0;//of the confidence interval
+};
+
+StratifiedMean estimate(const std::vector<std::vector<double>>& strata, const std::vector<size_t>& stratum_pages,
+                        size_t total_pages, double confidence) {
+  StratifiedMean result;
+  double var = 0;
+  size_t nsample = 0;
+  for(size_t h = 0; h < strata.size(); h++) {
+    if(strata[h].empty()) {
+      continue;
+    }
+    double weight = double(stratum_pages[h]) / total_pages;
+    double n = strata[h].size();
+    //finite population correction, a fully sampled stratum has no sampling error
+    double fpc = 1 - n / stratum_pages[h];
+    result.mean += weight * mean(strata[h]);
+    var += weight * weight * fpc * variance(strata[h]) / n;
+    nsample += strata[h].size();
+  }
+  double dof = std::max<double>(1, double(nsample) - strata.size());
+  result.half_width = studentTQuantile(confidence, dof) * std::sqrt(var);
+  return result;
+}
+
+//Floyd's algorithm: count distinct page indices of [0, range) without materializing the range
+std::vector<size_t> samplePages(size_t range, size_t count, std::mt19937_64& generator) {
+  std::unordered_set<size_t> chosen;
+  for(size_t j = range - count; j < range; j++) {
+    size_t t = std::uniform_int_distribution<size_t>(0, j)(generator);
+    chosen.insert(chosen.count(t) ? j : t);
+  }
+  std::vector<size_t> pages(chosen.begin(), chosen.end());
+  std::sort(pages.begin(), pages.end());//sequential reads
+  return pages;
+}
+
+//MiB/Second interval from a time-per-page interval, the bounds swap under inversion
+void printThroughput(const char* name, const StratifiedMean& ns) {
+  auto tpt = [](double ns_per_page) {
+    return ns_per_page > 0 ? kPageSize / ns_per_page * 1e9 / kMegaByte : 0;
+  };
+  std::cout << ", " << name << " " << tpt(ns.mean) << " MiB/Second ["
+            << tpt(ns.mean + ns.half_width) << ", " << tpt(std::max(ns.mean - ns.half_width, 0.0)) << "]";
+}
+
+}
+
+int runProfiler(const ProfileConfig& profile) {
+  int fd = open(profile.path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    std::cerr << "[ERROR]: can't open " << profile.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t total_pages = std::filesystem::file_size(profile.path) / kPageSize;
+  if(total_pages == 0) {
+    std::cerr << "[ERROR]: " << profile.path << " is smaller than a page" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t nsample = std::min(profile.sample_pages, total_pages);
+  //at least two pages per stratum so each has a variance
+  size_t nstrata = std::max<size_t>(1, std::min(profile.strata, nsample / 2));
+
+  //proportional allocation over equally sized strata, the last stratum takes the remainder
+  std::mt19937_64 generator(profile.seed);
+  std::vector<size_t> stratum_pages(nstrata);
+  std::vector<size_t> stratum_of;//stratum of each sampled page
+  std::vector<size_t> page_ids;
+  for(size_t h = 0; h < nstrata; h++) {
+    size_t begin = total_pages * h / nstrata;
+    size_t end = total_pages * (h + 1) / nstrata;
+    stratum_pages[h] = end - begin;
+    size_t count = std::min(stratum_pages[h], nsample * (h + 1) / nstrata - nsample * h / nstrata);
+    for(size_t page : samplePages(stratum_pages[h], count, generator)) {
+      page_ids.push_back(begin + page);
+      stratum_of.push_back(h);
+    }
+  }
+  nsample = page_ids.size();
+
+  char* pages = (char*) aligned_alloc(kPageSize, nsample * kPageSize);
+  Timer timer;
+  timer.start();
+  for(size_t i = 0; i < nsample; i++) {
+    if(pread(fd, pages + i * kPageSize, kPageSize, off_t(page_ids[i] * kPageSize)) != ssize_t(kPageSize)) {
+      std::cerr << "[ERROR]: short read at page " << page_ids[i] << " of " << profile.path << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  close(fd);
+  std::cout << "[INFO]: profile " << profile.path << ", " << total_pages << " pages, sampled " << nsample
+            << " pages in " << nstrata << " strata (read in " << timer.duration_us() / 1000 << " ms), "
+            << 100 * profile.confidence << "% confidence intervals" << std::endl;
+
+  char* compressed = (char*) aligned_alloc(kPageSize, 2 * kPageSize);
+  char* decompressed = (char*) aligned_alloc(kPageSize, kPageSize);
+  bool round_trip_failed = false;
+  for(const std::string& algorithm : profile.algorithms) {
+    std::unique_ptr<LosslessCompressor> compressor = createCompressor(algorithm);
+    std::vector<std::vector<double>> bytes(nstrata), compress_ns(nstrata), decompress_ns(nstrata);
+    size_t failed = 0;
+    for(size_t i = 0; i < nsample; i++) {
+      char* page = pages + i * kPageSize;
+      timer.start();
+      size_t res = compressor->compress(compressed, 2 * kPageSize, page, kPageSize);
+      long compress_drt = timer.duration_ns();
+      timer.start();
+      size_t out = compressor->decompress(decompressed, kPageSize, compressed, res);
+      long decompress_drt = timer.duration_ns();
+      failed += out != kPageSize || memcmp(decompressed, page, kPageSize) != 0;
+      bytes[stratum_of[i]].push_back(res);
+      compress_ns[stratum_of[i]].push_back(compress_drt);
+      decompress_ns[stratum_of[i]].push_back(decompress_drt);
+    }
+
+    //ratio = page size / mean compressed size, the interval maps through the same inversion
+    StratifiedMean size = estimate(bytes, stratum_pages, total_pages, profile.confidence);
+    double lo = std::max(size.mean - size.half_width, 1.0);
+    double hi = size.mean + size.half_width;
+    std::cout << "[INFO]: " << algorithm << " ratio " << kPageSize / size.mean << " [" << kPageSize / hi
+              << ", " << kPageSize / lo << "], compressed size " << size.mean * total_pages / kMegaByte
+              << " MiB [" << lo * total_pages / kMegaByte << ", " << hi * total_pages / kMegaByte << "]";
+    printThroughput("compression", estimate(compress_ns, stratum_pages, total_pages, profile.confidence));
+    printThroughput("decompression", estimate(decompress_ns, stratum_pages, total_pages, profile.confidence));
+    std::cout << std::endl;
+    if(failed) {
+      std::cout << "[ERROR]: " << algorithm << " failed to round-trip " << failed << " sampled pages" << std::endl;
+      round_trip_failed = true;
+    }
+  }
+
+  free(decompressed);
+  free(compressed);
+  free(pages);
+  return round_trip_failed ? EXIT_FAILURE : 0;
+}
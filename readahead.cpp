@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <random>
+#include "compress.h"
+#include "benchmark.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+namespace {
+
+enum class ReadaheadPolicy {
+  None,//the faulting page only
+  Fixed,//always max_window pages
+  Adaptive,//sized from the readahead hits since the last fault, as the kernel's swapin_nr_pages
+};
+
+const char* policyName(ReadaheadPolicy policy) {
+  switch(policy) {
+    case ReadaheadPolicy::None:
+      return "none";
+    case ReadaheadPolicy::Fixed:
+      return "fixed";
+    default:
+      return "adaptive";
+  }
+}
+
+struct ReadaheadStats {
+  size_t major_faults = 0;//page not in the swap cache, a window was decompressed
+  size_t readahead_hits = 0;//page found in the swap cache thanks to an earlier window
+  size_t cache_hits = 0;//page still cached from its own fault
+  size_t decompressed = 0;//pages
+  size_t useful = 0;//read ahead and accessed before eviction
+  size_t wasted = 0;//read ahead and evicted, or left, without an access
+  size_t mismatches = 0;
+  long decompress_ns = 0;
+  std::vector<long> fault_ns;
+};
+
+/**
+ * @brief window of the next major fault from the readahead hits since the previous one,
+ * following mm/swap_state.c: hits + 2 rounded up to a power of two from 4, a single page
+ * without hits unless the fault is adjacent to the previous one, never below half the
+ * previous window
+ * */
+size_t adaptiveWindow(size_t hits, size_t pid, size_t prev_pid, size_t prev_window, size_t max_window) {
+  size_t pages = hits + 2;
+  if(pages == 2) {
+    if(pid != prev_pid + 1 && pid + 1 != prev_pid) {
+      pages = 1;
+    }
+  } else {
+    size_t roundup = 4;
+    while(roundup < pages) {
+      roundup <<= 1;
+    }
+    pages = roundup;
+  }
+  pages = std::min(pages, max_window);
+  return std::max(pages, prev_window / 2);
+}
+
+/**
+ * @brief swap cache of decompressed pages with lru eviction, remembers which pages came in by
+ * readahead and were not accessed yet
+ * */
+class SwapCache {
+ public:
+  SwapCache(size_t npages, size_t capacity)
+      : frame_of_(npages, SIZE_MAX), position_(npages), unused_(npages, false),
+        frames_((char*) aligned_alloc(kPageSize, capacity * kPageSize)) {
+    for(size_t frame = capacity; frame > 0; frame--) {
+      free_frames_.push_back(frame - 1);
+    }
+  }
+
+  ~SwapCache() { free(frames_); }
+
+  bool cached(size_t pid) const { return frame_of_[pid] != SIZE_MAX; }
+
+  char* frame(size_t pid) { return frames_ + frame_of_[pid] * kPageSize; }
+
+  //move to the lru head, true when this is the first access to a read-ahead page
+  bool touch(size_t pid) {
+    lru_.splice(lru_.begin(), lru_, position_[pid]);
+    bool first = unused_[pid];
+    unused_[pid] = false;
+    return first;
+  }
+
+  //frame for a page about to be decompressed, evicting the lru tail if full
+  char* insert(size_t pid, bool readahead, ReadaheadStats& stats) {
+    if(free_frames_.empty()) {
+      size_t victim = lru_.back();
+      lru_.pop_back();
+      stats.wasted += unused_[victim];
+      unused_[victim] = false;
+      free_frames_.push_back(frame_of_[victim]);
+      frame_of_[victim] = SIZE_MAX;
+    }
+    frame_of_[pid] = free_frames_.back();
+    free_frames_.pop_back();
+    lru_.push_front(pid);
+    position_[pid] = lru_.begin();
+    unused_[pid] = readahead;
+    return frame(pid);
+  }
+
+  size_t unusedPages() const { return std::count(unused_.begin(), unused_.end(), true); }
+
+ private:
+  std::vector<size_t> frame_of_;
+  std::vector<std::list<size_t>::iterator> position_;
+  std::vector<bool> unused_;
+  std::list<size_t> lru_;
+  std::vector<size_t> free_frames_;
+  char* frames_;
+};
+
+std::string percentiles(std::vector<long>& samples) {
+  if(samples.empty()) {
+    return "none";
+  }
+  std::sort(samples.begin(), samples.end());
+  auto at = [&](double q) { return samples[std::min(samples.size() - 1, size_t(q * samples.size()))] / 1000.0; };
+  char text[160];
+  snprintf(text, sizeof(text), "p50 %.2f p90 %.2f p99 %.2f max %.2f us", at(0.5), at(0.9), at(0.99),
+           samples.back() / 1000.0);
+  return text;
+}
+
+}
+
+int runReadahead(const ReadaheadConfig& readahead) {
+  std::ifstream fin(readahead.path);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << readahead.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t size = std::filesystem::file_size(readahead.path);
+  if(readahead.limit_bytes) {
+    size = std::min(size, readahead.limit_bytes);
+  }
+  size_t npages = size / kPageSize;
+  size = npages * kPageSize;
+  if(npages == 0 || readahead.max_window == 0) {
+    std::cerr << "[ERROR]: nothing to swap in " << readahead.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  char* origin = (char*) aligned_alloc(kPageSize, size);
+  fin.read(origin, size);
+  //a window never evicts its own pages
+  size_t capacity = std::max(readahead.max_window, size_t(npages * readahead.resident_fraction));
+  size_t naccess = readahead.accesses ? readahead.accesses : 4 * npages;
+
+  //the same access stream for every algorithm and policy: runs of the next page, random jumps
+  std::vector<size_t> accesses(naccess);
+  std::mt19937_64 generator(readahead.seed);
+  std::bernoulli_distribution sequential(readahead.sequential);
+  std::uniform_int_distribution<size_t> any_page(0, npages - 1);
+  size_t current = any_page(generator);
+  for(size_t& pid : accesses) {
+    current = sequential(generator) ? (current + 1) % npages : any_page(generator);
+    pid = current;
+  }
+  std::cout << "[INFO]: swap readahead " << readahead.path << ", " << npages << " pages, swap cache " << capacity
+            << " pages, " << naccess << " accesses, " << 100 * readahead.sequential << "% sequential, window up to "
+            << readahead.max_window << " pages" << std::endl;
+
+  bool failed = false;
+  for(const std::string& algorithm : readahead.algorithms) {
+    std::unique_ptr<LosslessCompressor> compressor = createCompressor(algorithm);
+    std::vector<std::vector<char>> slots(npages);
+    //lzo-rle may run the lzo worst case (a page and a sixteenth) through rle doubling it
+    std::vector<char> scratch(3 * kPageSize);
+    for(size_t pid = 0; pid < npages; pid++) {
+      size_t res = compressor->compress(scratch.data(), scratch.size(), origin + pid * kPageSize, kPageSize);
+      slots[pid].assign(scratch.data(), scratch.data() + res);
+    }
+
+    for(ReadaheadPolicy policy : {ReadaheadPolicy::None, ReadaheadPolicy::Fixed, ReadaheadPolicy::Adaptive}) {
+      SwapCache cache(npages, capacity);
+      ReadaheadStats stats;
+      std::vector<void*> dst, src;
+      std::vector<size_t> src_len, decompressed, window_pages;
+      size_t hits_since_fault = 0;
+      size_t prev_pid = SIZE_MAX - 1, prev_window = 1;
+      Timer timer;
+      for(size_t pid : accesses) {
+        if(cache.cached(pid)) {
+          if(cache.touch(pid)) {
+            stats.readahead_hits++;
+            stats.useful++;
+            hits_since_fault++;
+            //read-ahead pages are checked on their first touch, the faulting one right away
+            stats.mismatches += memcmp(cache.frame(pid), origin + pid * kPageSize, kPageSize) != 0;
+          } else {
+            stats.cache_hits++;
+          }
+          continue;
+        }
+        timer.start();
+        size_t window = policy == ReadaheadPolicy::None ? 1
+                        : policy == ReadaheadPolicy::Fixed
+                            ? readahead.max_window
+                            : adaptiveWindow(hits_since_fault, pid, prev_pid, prev_window, readahead.max_window);
+        //the kernel reads the window-aligned cluster around the fault, the faulting page first
+        size_t start = pid / window * window;
+        window_pages.assign(1, pid);
+        for(size_t other = start; other < std::min(start + window, npages); other++) {
+          if(other != pid && !cache.cached(other)) {
+            window_pages.push_back(other);
+          }
+        }
+        dst.clear();
+        src.clear();
+        src_len.clear();
+        for(size_t other : window_pages) {
+          dst.push_back(cache.insert(other, other != pid, stats));
+          src.push_back(slots[other].data());
+          src_len.push_back(slots[other].size());
+        }
+        decompressed.resize(window_pages.size());
+        Timer decompress_timer;
+        decompress_timer.start();
+        if(window_pages.size() == 1) {
+          decompressed[0] = compressor->decompress(dst[0], kPageSize, src[0], src_len[0]);
+        } else {
+          compressor->decompressBatch(dst.data(), kPageSize, src.data(), src_len.data(), decompressed.data(),
+                                      window_pages.size());
+        }
+        stats.decompress_ns += decompress_timer.duration_ns();
+        stats.fault_ns.push_back(timer.duration_ns());
+        stats.major_faults++;
+        stats.decompressed += window_pages.size();
+        for(size_t len : decompressed) {
+          stats.mismatches += len != kPageSize;
+        }
+        stats.mismatches += memcmp(cache.frame(pid), origin + pid * kPageSize, kPageSize) != 0;
+        cache.touch(pid);
+        hits_since_fault = 0;
+        prev_pid = pid;
+        prev_window = window;
+      }
+      stats.wasted += cache.unusedPages();
+
+      size_t read_ahead = stats.decompressed - stats.major_faults;
+      double decompress_ms = stats.decompress_ns / 1e6;
+      std::cout << "[INFO]: " << algorithm << " " << policyName(policy) << ": " << stats.major_faults
+                << " major faults, " << stats.readahead_hits << " readahead hits, " << stats.cache_hits
+                << " cache hits, " << stats.decompressed << " pages decompressed (" << read_ahead
+                << " read ahead: " << stats.useful << " useful, " << stats.wasted << " wasted, "
+                << (read_ahead ? 100.0 * stats.wasted / read_ahead : 0) << "%)" << std::endl;
+      std::cout << "[INFO]: " << algorithm << " " << policyName(policy) << ": decompression " << decompress_ms
+                << " ms in total, " << decompress_ms * stats.wasted / std::max<size_t>(stats.decompressed, 1)
+                << " ms of it wasted, fault latency " << percentiles(stats.fault_ns) << std::endl;
+      if(stats.mismatches) {
+        std::cout << "[ERROR]: " << algorithm << " " << policyName(policy) << ": " << stats.mismatches
+                  << " pages decompressed to the wrong size or data" << std::endl;
+        failed = true;
+      }
+    }
+  }
+  free(origin);
+  return failed ? EXIT_FAILURE : 0;
+}
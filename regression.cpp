@@ -0,0 +1,176 @@
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "benchmark.h"
+#include "stats.h"
+
+using namespace util;
+
+//significance level of the one-sided regression test
+static constexpr double kAlpha = 0.05;
+
+namespace {
+
+struct BaselineRow {
+  std::string input_file;
+  std::string algorithm;
+  int level = 0;//optional column, 0 for the engine default
+  bool page_shuffle = false;
+  size_t block_size = 0;//pages
+  size_t iterations = 0;
+  double compression_throughput = 0;
+  double compression_ratio = 0;
+  double decompression_throughput = 0;
+};
+
+std::vector<std::string> splitCsvLine(const std::string& line) {
+  std::vector<std::string> fields;
+  std::stringstream stream(line);
+  std::string field;
+  while(std::getline(stream, field, ',')) {
+    fields.push_back(field);
+  }
+  return fields;
+}
+
+std::vector<BaselineRow> loadBaseline(const std::string& path) {
+  std::ifstream fin(path);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::string line;
+  std::getline(fin, line);
+  std::map<std::string, size_t> column;
+  std::vector<std::string> header = splitCsvLine(line);
+  for(size_t i = 0; i < header.size(); i++) {
+    column[header[i]] = i;
+  }
+  for(const char* name : {"input_file", "algorithm", "page_shuffle", "block_size", "iterations",
+                          "compression_throughput", "compression_ratio", "decompression_throughput"}) {
+    if(!column.count(name)) {
+      std::cerr << "[ERROR]: baseline " << path << " has no column " << name << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  std::vector<BaselineRow> rows;
+  while(std::getline(fin, line)) {
+    std::vector<std::string> fields = splitCsvLine(line);
+    if(fields.size() < header.size()) {
+      continue;
+    }
+    BaselineRow row;
+    row.input_file = fields[column["input_file"]];
+    row.algorithm = fields[column["algorithm"]];
+    row.level = column.count("level") ? std::stoi(fields[column["level"]]) : 0;
+    row.page_shuffle = std::stoi(fields[column["page_shuffle"]]);
+    row.block_size = std::stoul(fields[column["block_size"]]);
+    row.iterations = std::stoul(fields[column["iterations"]]);
+    row.compression_throughput = std::stod(fields[column["compression_throughput"]]);
+    row.compression_ratio = std::stod(fields[column["compression_ratio"]]);
+    row.decompression_throughput = std::stod(fields[column["decompression_throughput"]]);
+    rows.push_back(row);
+  }
+  return rows;
+}
+
+/**
+ * @brief compare one higher-is-better metric, a regression must be both larger than the
+ * threshold and statistically significant
+ * @return whether the metric regressed
+ * */
+bool checkMetric(const std::string& name, const char* metric, const std::vector<double>& baseline,
+                 const std::vector<double>& current, double threshold) {
+  double before = mean(baseline);
+  double after = mean(current);
+  double change = before > 0 ? (after - before) / before : 0;
+  double p_value = lowerMeanPValue(baseline, current);
+  bool regressed = change < -threshold && p_value < kAlpha;
+  (regressed ? std::cout << "[ERROR]: regression " : std::cout << "[INFO]: ")
+      << name << " " << metric << " " << before << " -> " << after
+      << " (" << (change >= 0 ? "+" : "") << 100 * change << "%, p " << p_value << ")" << std::endl;
+  return regressed;
+}
+
+}
+
+int runRegression(const std::string& baseline, const std::string& data_dir, size_t repeat,
+                  double threshold, double ratio_threshold, const std::string& output) {
+  std::vector<BaselineRow> rows = loadBaseline(baseline);
+  //group rows by every configuration column: iterations change the throughput too, so mixing them
+  //would count that gap as noise; rows of a group are repeated runs of the same configuration
+  std::map<std::string, std::vector<BaselineRow>> groups;
+  for(const BaselineRow& row : rows) {
+    std::string key = row.input_file + "/" + row.algorithm + (row.level ? ":" + std::to_string(row.level) : "")
+                      + "/block " + std::to_string(row.block_size)
+                      + "/shuffle " + std::to_string(row.page_shuffle) + "/iterations "
+                      + std::to_string(row.iterations);
+    groups[key].push_back(row);
+  }
+
+  std::ofstream fout;
+  if(!output.empty()) {
+    fout.open(output);
+    fout << "input_file,algorithm,level,page_shuffle,block_size,iterations,file_size,nblocks,"
+            "compression_throughput,compression_ratio,decompression_throughput" << std::endl;
+  }
+
+  std::cout << "[INFO]: baseline " << baseline << ", " << groups.size() << " configurations, "
+            << repeat << " runs each" << std::endl;
+  size_t regressions = 0;
+  for(const auto& [name, group] : groups) {
+    std::vector<double> base_ctpt, base_ratio, base_dtpt;
+    std::vector<double> cur_ctpt, cur_ratio, cur_dtpt;
+    bool failed = false;
+    for(const BaselineRow& row : group) {
+      base_ctpt.push_back(row.compression_throughput);
+      base_ratio.push_back(row.compression_ratio);
+      base_dtpt.push_back(row.decompression_throughput);
+
+      BenchConfig config;
+      config.path = (std::filesystem::path(data_dir) / row.input_file).string();
+      config.block_pages = row.block_size;
+      config.niteration = row.iterations;
+      config.page_shuffle = row.page_shuffle;
+      config.algorithm = row.algorithm;
+      config.level = row.level;
+      config.verify = true;
+      config.verbose = false;
+      //one discarded warm-up run: page cache, allocator and cpu frequency settle first
+      runBenchmark(config);
+      for(size_t r = 0; r < repeat; r++) {
+        BenchResult result = runBenchmark(config);
+        failed |= result.failed;
+        cur_ctpt.push_back(result.compression_throughput);
+        cur_ratio.push_back(result.compression_ratio);
+        cur_dtpt.push_back(result.decompression_throughput);
+        if(fout.is_open()) {
+          fout << row.input_file << "," << row.algorithm << "," << row.level << "," << row.page_shuffle << "," << row.block_size << ","
+               << row.iterations << "," << result.file_size << "," << result.nblocks << ","
+               << result.compression_throughput << "," << result.compression_ratio << ","
+               << result.decompression_throughput << std::endl;
+        }
+      }
+    }
+    bool regressed = failed;
+    if(failed) {
+      std::cout << "[ERROR]: regression " << name << " failed round-trip verification" << std::endl;
+    }
+    regressed |= checkMetric(name, "compression throughput", base_ctpt, cur_ctpt, threshold);
+    regressed |= checkMetric(name, "decompression throughput", base_dtpt, cur_dtpt, threshold);
+    regressed |= checkMetric(name, "compression ratio", base_ratio, cur_ratio, ratio_threshold);
+    regressions += regressed;
+  }
+
+  if(regressions) {
+    std::cout << "[ERROR]: " << regressions << " of " << groups.size() << " configurations regressed" << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "[INFO]: no significant regression in " << groups.size() << " configurations" << std::endl;
+  return 0;
+}
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_RLE_H
+#define FASTCOMPRESS_RLE_H
+
+
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+#include "cpu_features.h"
+
+namespace FastCompress {
+
+/**
+ * byte-oriented run length coding used by LZORLE: every run is stored as a (byte, run length)
+ * pair with run length in [1, 255], so the encoded size is at most twice the input
+ * */
+
+//rle encode kernel: input, input length, output of at least 2 * input length -> encoded size
+using RleEncodeFn = size_t (*)(const unsigned char* input, size_t input_len, unsigned char* output);
+//rle decode kernel: input, input length, output of rleDecodedSize() + kRleDecodeSlack bytes
+using RleDecodeFn = void (*)(const unsigned char* input, size_t input_len, unsigned char* output);
+
+//interleaved rle decode kernel: n <= kMaxRleInterleave streams of (input, input length, output)
+using RleDecodeInterleavedFn = void (*)(const unsigned char* const* inputs, const size_t* input_lens,
+                                        unsigned char* const* outputs, size_t n);
+
+//vector decoders store whole registers, so the output may be written up to this far past the end
+static constexpr size_t kRleDecodeSlack = 64;
+static constexpr size_t kRleMaxRun = 255;
+static constexpr size_t kMaxRleInterleave = 4;
+
+namespace detail {
+
+inline size_t rleEncodeScalar(const unsigned char* input, size_t input_len, unsigned char* output) {
+  unsigned char* out = output;
+  size_t i = 0;
+  while(i < input_len) {
+    unsigned char current_byte = input[i];
+    size_t limit = std::min(kRleMaxRun, input_len - i);
+    size_t run_length = 1;
+    while(run_length < limit && input[i + run_length] == current_byte) {
+      run_length++;
+    }
+    *out++ = current_byte;
+    *out++ = (unsigned char)run_length;
+    i += run_length;
+  }
+  return out - output;
+}
+
+inline void rleDecodeScalar(const unsigned char* input, size_t input_len, unsigned char* output) {
+  for(size_t i = 0; i + 1 < input_len; i += 2) {
+    memset(output, input[i], input[i + 1]);
+    output += input[i + 1];
+  }
+}
+
+/**
+ * @brief interleaved decoders expand one run of every stream per round, so the dependent
+ * load -> store chains of independent streams overlap
+ * */
+inline void rleDecodeInterleavedScalar(const unsigned char* const* inputs, const size_t* input_lens,
+                                       unsigned char* const* outputs, size_t n) {
+  unsigned char* out[kMaxRleInterleave];
+  size_t longest = 0;
+  for(size_t s = 0; s < n; s++) {
+    out[s] = outputs[s];
+    longest = std::max(longest, input_lens[s]);
+  }
+  for(size_t i = 0; i + 1 < longest; i += 2) {
+    for(size_t s = 0; s < n; s++) {
+      if(i + 1 < input_lens[s]) {
+        memset(out[s], inputs[s][i], inputs[s][i + 1]);
+        out[s] += inputs[s][i + 1];
+      }
+    }
+  }
+}
+
+#if defined(__x86_64__)
+/**
+ * @brief vector encoders compare a whole register against the broadcast run byte and take the
+ * run length from the first mismatch, the scalar loop after it then stops at once or finishes
+ * the bytes near the end of input; single-byte runs, the common case in lzo output, skip the vector path
+ * */
+__attribute__((target("sse4.2")))
+inline size_t rleEncodeSse42(const unsigned char* input, size_t input_len, unsigned char* output) {
+  unsigned char* out = output;
+  size_t i = 0;
+  while(i < input_len) {
+    unsigned char current_byte = input[i];
+    size_t limit = std::min(kRleMaxRun, input_len - i);
+    if(limit == 1 || input[i + 1] != current_byte) {
+      *out++ = current_byte;
+      *out++ = 1;
+      i++;
+      continue;
+    }
+    __m128i broadcast = _mm_set1_epi8((char)current_byte);
+    size_t run_length = 0;
+    while(run_length + 16 <= limit) {
+      __m128i v = _mm_loadu_si128((const __m128i*)(input + i + run_length));
+      uint32_t mismatch = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(v, broadcast)) & 0xffffu;
+      if(mismatch) {
+        run_length += __builtin_ctz(mismatch);
+        break;
+      }
+      run_length += 16;
+    }
+    while(run_length < limit && input[i + run_length] == current_byte) {
+      run_length++;
+    }
+    *out++ = current_byte;
+    *out++ = (unsigned char)run_length;
+    i += run_length;
+  }
+  return out - output;
+}
+
+__attribute__((target("avx2")))
+inline size_t rleEncodeAvx2(const unsigned char* input, size_t input_len, unsigned char* output) {
+  unsigned char* out = output;
+  size_t i = 0;
+  while(i < input_len) {
+    unsigned char current_byte = input[i];
+    size_t limit = std::min(kRleMaxRun, input_len - i);
+    if(limit == 1 || input[i + 1] != current_byte) {
+      *out++ = current_byte;
+      *out++ = 1;
+      i++;
+      continue;
+    }
+    __m256i broadcast = _mm256_set1_epi8((char)current_byte);
+    size_t run_length = 0;
+    while(run_length + 32 <= limit) {
+      __m256i v = _mm256_loadu_si256((const __m256i*)(input + i + run_length));
+      uint32_t mismatch = ~(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, broadcast));
+      if(mismatch) {
+        run_length += __builtin_ctz(mismatch);
+        break;
+      }
+      run_length += 32;
+    }
+    while(run_length < limit && input[i + run_length] == current_byte) {
+      run_length++;
+    }
+    *out++ = current_byte;
+    *out++ = (unsigned char)run_length;
+    i += run_length;
+  }
+  return out - output;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline size_t rleEncodeAvx512(const unsigned char* input, size_t input_len, unsigned char* output) {
+  unsigned char* out = output;
+  size_t i = 0;
+  while(i < input_len) {
+    unsigned char current_byte = input[i];
+    size_t limit = std::min(kRleMaxRun, input_len - i);
+    if(limit == 1 || input[i + 1] != current_byte) {
+      *out++ = current_byte;
+      *out++ = 1;
+      i++;
+      continue;
+    }
+    __m512i broadcast = _mm512_set1_epi8((char)current_byte);
+    size_t run_length = 0;
+    while(run_length + 64 <= limit) {
+      uint64_t mismatch = ~_mm512_cmpeq_epi8_mask(_mm512_loadu_si512(input + i + run_length), broadcast);
+      if(mismatch) {
+        run_length += __builtin_ctzll(mismatch);
+        break;
+      }
+      run_length += 64;
+    }
+    if(run_length < limit && limit - run_length < 64) {
+      //masked load covers the remaining bytes of the run window without reading past the input
+      __mmask64 valid = (1ull << (limit - run_length)) - 1;
+      __m512i v = _mm512_maskz_loadu_epi8(valid, input + i + run_length);
+      uint64_t mismatch = ~_mm512_mask_cmpeq_epi8_mask(valid, v, broadcast) & valid;
+      run_length += mismatch ? __builtin_ctzll(mismatch) : limit - run_length;
+    }
+    *out++ = current_byte;
+    *out++ = (unsigned char)run_length;
+    i += run_length;
+  }
+  return out - output;
+}
+
+__attribute__((target("avx2")))
+inline void rleDecodeAvx2(const unsigned char* input, size_t input_len, unsigned char* output) {
+  for(size_t i = 0; i + 1 < input_len; i += 2) {
+    __m256i broadcast = _mm256_set1_epi8((char)input[i]);
+    size_t run_length = input[i + 1];
+    for(size_t j = 0; j < run_length; j += 32) {
+      _mm256_storeu_si256((__m256i*)(output + j), broadcast);
+    }
+    output += run_length;
+  }
+}
+
+__attribute__((target("avx2")))
+inline void rleDecodeInterleavedAvx2(const unsigned char* const* inputs, const size_t* input_lens,
+                                     unsigned char* const* outputs, size_t n) {
+  unsigned char* out[kMaxRleInterleave];
+  size_t longest = 0;
+  for(size_t s = 0; s < n; s++) {
+    out[s] = outputs[s];
+    longest = std::max(longest, input_lens[s]);
+  }
+  for(size_t i = 0; i + 1 < longest; i += 2) {
+    for(size_t s = 0; s < n; s++) {
+      if(i + 1 < input_lens[s]) {
+        __m256i broadcast = _mm256_set1_epi8((char)inputs[s][i]);
+        size_t run_length = inputs[s][i + 1];
+        for(size_t j = 0; j < run_length; j += 32) {
+          _mm256_storeu_si256((__m256i*)(out[s] + j), broadcast);
+        }
+        out[s] += run_length;
+      }
+    }
+  }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline void rleDecodeAvx512(const unsigned char* input, size_t input_len, unsigned char* output) {
+  for(size_t i = 0; i + 1 < input_len; i += 2) {
+    __m512i broadcast = _mm512_set1_epi8((char)input[i]);
+    size_t run_length = input[i + 1];
+    for(size_t j = 0; j < run_length; j += 64) {
+      _mm512_storeu_si512(output + j, broadcast);
+    }
+    output += run_length;
+  }
+}
+#endif
+
+}
+
+/**
+ * @brief rle encoder implementations, ordered slowest first
+ * */
+inline const std::vector<DispatchKernel<RleEncodeFn>>& rleEncodeKernels() {
+  static const std::vector<DispatchKernel<RleEncodeFn>> kernels = {
+    {"scalar", anyCpu, detail::rleEncodeScalar},
+#if defined(__x86_64__)
+    {"sse4.2", hasSse42, detail::rleEncodeSse42},
+    {"avx2", hasAvx2, detail::rleEncodeAvx2},
+    {"avx512", hasAvx512bw, detail::rleEncodeAvx512},
+#endif
+  };
+  return kernels;
+}
+
+/**
+ * @brief rle decoder implementations, ordered slowest first
+ * */
+inline const std::vector<DispatchKernel<RleDecodeFn>>& rleDecodeKernels() {
+  static const std::vector<DispatchKernel<RleDecodeFn>> kernels = {
+    {"scalar", anyCpu, detail::rleDecodeScalar},
+#if defined(__x86_64__)
+    {"avx2", hasAvx2, detail::rleDecodeAvx2},
+    {"avx512", hasAvx512bw, detail::rleDecodeAvx512},
+#endif
+  };
+  return kernels;
+}
+
+/**
+ * @brief interleaved rle decoder implementations, ordered slowest first
+ * */
+inline const std::vector<DispatchKernel<RleDecodeInterleavedFn>>& rleDecodeInterleavedKernels() {
+  static const std::vector<DispatchKernel<RleDecodeInterleavedFn>> kernels = {
+    {"scalar", anyCpu, detail::rleDecodeInterleavedScalar},
+#if defined(__x86_64__)
+    {"avx2", hasAvx2, detail::rleDecodeInterleavedAvx2},
+#endif
+  };
+  return kernels;
+}
+
+inline size_t rleEncode(const unsigned char* input, size_t input_len, unsigned char* output) {
+  static const RleEncodeFn fn = selectKernel(rleEncodeKernels()).fn;
+  return fn(input, input_len, output);
+}
+
+inline void rleDecode(const unsigned char* input, size_t input_len, unsigned char* output) {
+  static const RleDecodeFn fn = selectKernel(rleDecodeKernels()).fn;
+  fn(input, input_len, output);
+}
+
+//decode n <= kMaxRleInterleave independent streams in lock-step, outputs sized as for rleDecode()
+inline void rleDecodeInterleaved(const unsigned char* const* inputs, const size_t* input_lens,
+                                 unsigned char* const* outputs, size_t n) {
+  static const RleDecodeInterleavedFn fn = selectKernel(rleDecodeInterleavedKernels()).fn;
+  fn(inputs, input_lens, outputs, n);
+}
+
+//sum of run lengths, the exact size rleDecode() produces
+inline size_t rleDecodedSize(const unsigned char* input, size_t input_len) {
+  size_t size = 0;
+  for(size_t i = 1; i < input_len; i += 2) {
+    size += input[i];
+  }
+  return size;
+}
+
+}
+
+#endif //FASTCOMPRESS_RLE_H
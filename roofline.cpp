@@ -0,0 +1,68 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include "benchmark.h"
+#include "util.h"
+
+using namespace util;
+
+//repeat every pass and keep the fastest, the ceiling is the best the host can sustain
+static constexpr size_t kRooflineTrials = 3;
+
+//tell the compiler the buffer is observed, so a pass whose result is never read is not removed
+static inline void clobber(void* buffer) {
+  asm volatile("" : : "r"(buffer) : "memory");
+}
+
+static double passThroughput(size_t bytes, size_t niteration, long drt_us) {
+  return double(bytes * niteration) / kMegaByte / std::max(drt_us, 1l) * 1000000ul;
+}
+
+MemoryBandwidth measureBandwidth(size_t bytes, size_t niteration) {
+  MemoryBandwidth bandwidth;
+  bytes = std::max<size_t>(bytes / kPageSize * kPageSize, kPageSize);
+  char* src = (char*) aligned_alloc(kPageSize, bytes);
+  char* dst = (char*) aligned_alloc(kPageSize, bytes);
+  //touch both buffers first so page faults stay out of the timed passes
+  memset(src, 0x5a, bytes);
+  memset(dst, 0, bytes);
+  Timer timer;
+
+  for(size_t trial = 0; trial < kRooflineTrials; trial++) {
+    timer.start();
+    for(size_t i = 0; i < niteration; i++) {
+      memcpy(dst, src, bytes);
+      clobber(dst);
+    }
+    bandwidth.memcpy = std::max(bandwidth.memcpy, passThroughput(bytes, niteration, timer.duration_us()));
+
+    //streaming read: 4 independent accumulators so the add chain is not the bottleneck
+    uint64_t sum[4] = {0, 0, 0, 0};
+    const uint64_t* words = (const uint64_t*) src;
+    timer.start();
+    for(size_t i = 0; i < niteration; i++) {
+      for(size_t w = 0; w < bytes / sizeof(uint64_t); w += 4) {
+        sum[0] += words[w];
+        sum[1] += words[w + 1];
+        sum[2] += words[w + 2];
+        sum[3] += words[w + 3];
+      }
+    }
+    long drt = timer.duration_us();
+    volatile uint64_t keep = sum[0] ^ sum[1] ^ sum[2] ^ sum[3];//keep the read pass from being optimized away
+    (void) keep;
+    bandwidth.read = std::max(bandwidth.read, passThroughput(bytes, niteration, drt));
+
+    timer.start();
+    for(size_t i = 0; i < niteration; i++) {
+      memset(dst, (int) i, bytes);
+      clobber(dst);
+    }
+    bandwidth.write = std::max(bandwidth.write, passThroughput(bytes, niteration, timer.duration_us()));
+  }
+
+  free(dst);
+  free(src);
+  return bandwidth;
+}
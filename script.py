@@ -12,6 +12,7 @@ input_files = [
     # "reymont", "samba", "sao", "webster", "x-ray", "xml"
 ]
 algorithms = ["lz4", "lz4hc", "lzo", "lzo-rle", "zstd", "842"]
+compression_levels = {"lz4hc": [1, 3, 9], "zstd": [1, 3, 9]}  # 有压缩等级的算法逐级测试, 其余为 0 (默认)
 block_sizes = [1, 4]  # 分块大小 (以页数为单位)
 iterations = [1, 5]  # 循环次数
 page_shuffle_values = [0, 1]  # page_shuffle是否启用 (注意！0 或 1)
@@ -32,6 +33,8 @@ def parse_output(output):
     compression_throughput_match = re.search(r"\[INFO\]: compression throughput ([\d\.]+) MiB/Second", output)
     compression_ratio_match = re.search(r"\[INFO\]: compression ratio \(original size / compressed size\) ([\d\.]+)", output)
     decompression_throughput_match = re.search(r"\[INFO\]: decompression throughput ([\d\.]+) MiB/Second", output)
+    compression_energy_match = re.search(r"\[INFO\]: compression energy ([\d\.e\+\-]+) Joules/GiB", output)
+    decompression_energy_match = re.search(r"\[INFO\]: decompression energy ([\d\.e\+\-]+) Joules/GiB", output)
 
     # 提取匹配结果并存储
     if block_size_match:
@@ -48,18 +51,24 @@ def parse_output(output):
         result["compression_ratio"] = float(compression_ratio_match.group(1))
     if decompression_throughput_match:
         result["decompression_throughput"] = float(decompression_throughput_match.group(1))
+    if compression_energy_match:
+        result["compression_energy"] = float(compression_energy_match.group(1))
+    if decompression_energy_match:
+        result["decompression_energy"] = float(decompression_energy_match.group(1))
 
     return result
 
 # 定义函数运行命令并获取输出
-def run_compression_test(input_file, algorithm, block_size, n_iteration, page_shuffle):
+def run_compression_test(input_file, algorithm, level, block_size, n_iteration, page_shuffle):
     cmd = [
         "./FastCompress",  # 压缩程序的路径
         os.path.join("data", input_file),  # 输入文件路径
         str(block_size),  # 分块大小
         str(n_iteration),  # 循环次数
         str(page_shuffle),  # 是否启用页面打乱
-        algorithm  # 压缩算法
+        algorithm,  # 压缩算法
+        f"--level={level}",  # 压缩等级, 0 为算法默认
+        "--energy"  # RAPL 能耗 (焦耳/GiB), 计数器不可读时为 N/A
     ]
     
     try:
@@ -81,7 +90,7 @@ def run_compression_test(input_file, algorithm, block_size, n_iteration, page_sh
         return None
 
 # 计算总测试数量
-total_tests = len(input_files) * len(algorithms) * len(block_sizes) * len(iterations) * len(page_shuffle_values)
+total_tests = len(input_files) * sum(len(compression_levels.get(a, [0])) for a in algorithms) * len(block_sizes) * len(iterations) * len(page_shuffle_values)
 
 # 初始化计数器
 test_counter = 0
@@ -89,34 +98,38 @@ test_counter = 0
 # 运行所有测试并记录结果
 for input_file in input_files:
     for algorithm in algorithms:
-        for block_size in block_sizes:
-            for n_iteration in iterations:
-                for page_shuffle in page_shuffle_values:
-                    # 运行测试并获取输出
-                    outputlist = run_compression_test(input_file, algorithm, block_size, n_iteration, page_shuffle)
-
-                    # 更新计数器
-                    test_counter += 1
-
-                    # 打印并检查 outputlist 内容
-                    if outputlist is not None:
-                        results.append({
-                            "input_file": input_file,
-                            "algorithm": algorithm,
-                            "page_shuffle": page_shuffle,
-                            "block_size": outputlist.get("block_size", "N/A"),
-                            "iterations": outputlist.get("iterations", "N/A"),
-                            "file_size": outputlist.get("file_size", "N/A"),
-                            "nblocks": outputlist.get("nblocks", "N/A"),
-                            "compression_throughput": outputlist.get("compression_throughput", "N/A"),
-                            "compression_ratio": outputlist.get("compression_ratio", "N/A"),
-                            "decompression_throughput": outputlist.get("decompression_throughput", "N/A")
-                        })
-                    else:
-                        print(f"Test failed for {input_file}, {algorithm}, block_size={block_size}, iterations={n_iteration}, page_shuffle={page_shuffle}")
-
-                    # 显示进度条
-                    print(f"Progress: {test_counter}/{total_tests} ({(test_counter / total_tests) * 100:.2f}%)", end='\r')
+        for level in compression_levels.get(algorithm, [0]):
+            for block_size in block_sizes:
+                for n_iteration in iterations:
+                    for page_shuffle in page_shuffle_values:
+                        # 运行测试并获取输出
+                        outputlist = run_compression_test(input_file, algorithm, level, block_size, n_iteration, page_shuffle)
+
+                        # 更新计数器
+                        test_counter += 1
+
+                        # 打印并检查 outputlist 内容
+                        if outputlist is not None:
+                            results.append({
+                                "input_file": input_file,
+                                "algorithm": algorithm,
+                                "level": level,
+                                "page_shuffle": page_shuffle,
+                                "block_size": outputlist.get("block_size", "N/A"),
+                                "iterations": outputlist.get("iterations", "N/A"),
+                                "file_size": outputlist.get("file_size", "N/A"),
+                                "nblocks": outputlist.get("nblocks", "N/A"),
+                                "compression_throughput": outputlist.get("compression_throughput", "N/A"),
+                                "compression_ratio": outputlist.get("compression_ratio", "N/A"),
+                                "decompression_throughput": outputlist.get("decompression_throughput", "N/A"),
+                                "compression_energy": outputlist.get("compression_energy", "N/A"),
+                                "decompression_energy": outputlist.get("decompression_energy", "N/A")
+                            })
+                        else:
+                            print(f"Test failed for {input_file}, {algorithm}, level={level}, block_size={block_size}, iterations={n_iteration}, page_shuffle={page_shuffle}")
+
+                        # 显示进度条
+                        print(f"Progress: {test_counter}/{total_tests} ({(test_counter / total_tests) * 100:.2f}%)", end='\r')
 
 # 创建 DataFrame
 df = pd.DataFrame(results)
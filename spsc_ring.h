@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_SPSC_RING_H
+#define FASTCOMPRESS_SPSC_RING_H
+
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace FastCompress {
+
+/**
+ * @brief lock-free bounded queue between exactly one producer thread and one consumer thread.
+ *
+ * The producer's and the consumer's indices live on separate cache lines, each side next to its
+ * cached copy of the other side's index, so a push or pop only touches the shared line of the
+ * other side when the cached copy says the ring looks full or empty.
+ * */
+template<typename T>
+class SpscRing {
+ public:
+  //capacity is rounded up to a power of two
+  explicit SpscRing(size_t capacity) {
+    size_t slots = 2;
+    while(slots < capacity) {
+      slots <<= 1;
+    }
+    slots_.resize(slots);
+    mask_ = slots - 1;
+  }
+
+  SpscRing(const SpscRing&) = delete;
+
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  //producer only, false when the ring is full
+  bool push(const T& value) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if(tail - cached_head_ > mask_) {
+      cached_head_ = head_.load(std::memory_order_acquire);
+      if(tail - cached_head_ > mask_) {
+        return false;
+      }
+    }
+    slots_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  //consumer only, false when the ring is empty
+  bool pop(T& value) {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if(head == cached_tail_) {
+      cached_tail_ = tail_.load(std::memory_order_acquire);
+      if(head == cached_tail_) {
+        return false;
+      }
+    }
+    value = slots_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t capacity() const { return mask_ + 1; }
+
+ private:
+  static constexpr size_t kCacheLine = 64;
+
+  //producer side
+  alignas(kCacheLine) std::atomic<size_t> tail_{0};
+  size_t cached_head_ = 0;
+  //consumer side
+  alignas(kCacheLine) std::atomic<size_t> head_{0};
+  size_t cached_tail_ = 0;
+  //read-only after construction
+  alignas(kCacheLine) std::vector<T> slots_;
+  size_t mask_ = 0;
+};
+
+}
+
+#endif //FASTCOMPRESS_SPSC_RING_H
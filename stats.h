@@ -0,0 +1,118 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace util {
+
+  inline double mean(const std::vector<double>& samples) {
+    double sum = 0;
+    for(double sample : samples) {
+      sum += sample;
+    }
+    return samples.empty() ? 0 : sum / samples.size();
+  }
+
+  //unbiased sample variance, 0 for fewer than two samples
+  inline double variance(const std::vector<double>& samples) {
+    if(samples.size() < 2) {
+      return 0;
+    }
+    double m = mean(samples);
+    double sum = 0;
+    for(double sample : samples) {
+      sum += (sample - m) * (sample - m);
+    }
+    return sum / (samples.size() - 1);
+  }
+
+  //continued fraction of the regularized incomplete beta function (modified Lentz)
+  inline double betaContinuedFraction(double a, double b, double x) {
+    const double kTiny = 1e-300;
+    double c = 1, d = 1 - (a + b) * x / (a + 1);
+    d = 1 / (std::fabs(d) < kTiny ? kTiny : d);
+    double h = d;
+    for(int m = 1; m <= 300; m++) {
+      double numerator = m * (b - m) * x / ((a + 2 * m - 1) * (a + 2 * m));
+      d = 1 + numerator * d;
+      c = 1 + numerator / c;
+      d = 1 / (std::fabs(d) < kTiny ? kTiny : d);
+      c = std::fabs(c) < kTiny ? kTiny : c;
+      h *= d * c;
+      numerator = -(a + m) * (a + b + m) * x / ((a + 2 * m) * (a + 2 * m + 1));
+      d = 1 + numerator * d;
+      c = 1 + numerator / c;
+      d = 1 / (std::fabs(d) < kTiny ? kTiny : d);
+      c = std::fabs(c) < kTiny ? kTiny : c;
+      double delta = d * c;
+      h *= delta;
+      if(std::fabs(delta - 1) < 1e-12) {
+        break;
+      }
+    }
+    return h;
+  }
+
+  //regularized incomplete beta function I_x(a, b)
+  inline double incompleteBeta(double a, double b, double x) {
+    if(x <= 0) {
+      return 0;
+    }
+    if(x >= 1) {
+      return 1;
+    }
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b)
+                            + a * std::log(x) + b * std::log(1 - x));
+    if(x < (a + 1) / (a + b + 2)) {
+      return front * betaContinuedFraction(a, b, x) / a;
+    }
+    return 1 - front * betaContinuedFraction(b, a, 1 - x) / b;
+  }
+
+  //cumulative distribution function of student's t with dof degrees of freedom
+  inline double studentTCdf(double t, double dof) {
+    double tail = 0.5 * incompleteBeta(dof / 2, 0.5, dof / (dof + t * t));
+    return t > 0 ? 1 - tail : tail;
+  }
+
+  //two-sided quantile of student's t: the t with P(|T| <= t) = confidence, by bisection
+  inline double studentTQuantile(double confidence, double dof) {
+    double lo = 0, hi = 1000;
+    for(int i = 0; i < 200; i++) {
+      double mid = (lo + hi) / 2;
+      if(2 * studentTCdf(mid, dof) - 1 < confidence) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+    return (lo + hi) / 2;
+  }
+
+  /**
+   * @brief one-sided welch t-test, p-value of "current mean is lower than baseline mean";
+   * a single baseline sample falls back to a one-sample test against its value
+   * */
+  inline double lowerMeanPValue(const std::vector<double>& baseline, const std::vector<double>& current) {
+    double diff = mean(current) - mean(baseline);
+    double var_b = baseline.size() > 1 ? variance(baseline) / baseline.size() : 0;
+    double var_c = current.size() > 1 ? variance(current) / current.size() : 0;
+    double se2 = var_b + var_c;
+    if(se2 <= 0) {
+      //no spread at all (deterministic metric): any drop is significant
+      return diff < 0 ? 0 : 1;
+    }
+    double dof;
+    if(var_b == 0 || var_c == 0) {
+      dof = (var_b > 0 ? baseline.size() : current.size()) - 1.0;
+    } else {
+      dof = se2 * se2 / (var_b * var_b / (baseline.size() - 1) + var_c * var_c / (current.size() - 1));
+    }
+    return studentTCdf(diff / std::sqrt(se2), std::max(dof, 1.0));
+  }
+
+}
+
+#endif  // STATS_H
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include "compress.h"
+#include "log_store.h"
+#include "benchmark.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+//share of writes going to the hot fifth of the pages, so segments age unevenly
+static constexpr double kHotWriteShare = 0.8;
+
+namespace {
+
+std::string percentiles(std::vector<long>& samples) {
+  if(samples.empty()) {
+    return "none";
+  }
+  std::sort(samples.begin(), samples.end());
+  auto at = [&](double q) { return samples[std::min(samples.size() - 1, size_t(q * samples.size()))] / 1000.0; };
+  char text[160];
+  snprintf(text, sizeof(text), "p50 %.2f p99 %.2f p99.9 %.2f max %.2f us", at(0.5), at(0.99), at(0.999),
+           samples.back() / 1000.0);
+  return text;
+}
+
+}
+
+int runStore(const StoreConfig& store_config) {
+  std::ifstream fin(store_config.path);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << store_config.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t size = std::filesystem::file_size(store_config.path);
+  if(store_config.limit_bytes) {
+    size = std::min(size, store_config.limit_bytes);
+  }
+  size_t npages = size / kPageSize;
+  size = npages * kPageSize;
+  char* origin = (char*) aligned_alloc(kPageSize, size);
+  fin.read(origin, size);
+
+  //size the store from the first compression pass, plus slack for tombstones awaiting compaction
+  std::unique_ptr<LosslessCompressor> compressor = createCompressor(store_config.algorithm);
+  std::vector<char> scratch(2 * kPageSize);
+  std::vector<std::vector<char>> initial(npages);
+  size_t footprint = 0;
+  for(size_t pid = 0; pid < npages; pid++) {
+    size_t res = compressor->compress(scratch.data(), scratch.size(), origin + pid * kPageSize, kPageSize);
+    initial[pid].assign(scratch.data(), scratch.data() + res);
+    footprint += 16 + (res + 7) / 8 * 8;
+  }
+  size_t max_segments = size_t(footprint * (1 + store_config.slack) / store_config.segment_size) + 8;
+  LogStore store(npages, store_config.segment_size, max_segments);
+  for(size_t pid = 0; pid < npages; pid++) {
+    if(!store.put(pid, initial[pid].data(), initial[pid].size())) {
+      std::cerr << "[ERROR]: page " << pid << " compressed to " << initial[pid].size() << " bytes does not fit a "
+                << store_config.segment_size / 1024 << " KiB segment" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+  initial.clear();
+  std::cout << "[INFO]: log-structured store " << store_config.path << ", " << npages << " pages, "
+            << max_segments << " segments of " << store_config.segment_size / 1024 << " KiB ("
+            << 100 * store_config.slack << "% slack), " << store_config.readers << " readers, 1 writer, "
+            << store_config.seconds << " s" << std::endl;
+
+  std::atomic<bool> stop{false};
+  std::atomic<size_t> writes{0};
+  std::atomic<size_t> invalidations{0};
+  std::thread writer([&]() {
+    std::unique_ptr<LosslessCompressor> writer_compressor = createCompressor(store_config.algorithm);
+    std::vector<char> buffer(2 * kPageSize);
+    std::mt19937_64 generator(1);
+    std::bernoulli_distribution hot(kHotWriteShare);
+    std::bernoulli_distribution drop(store_config.invalidate_ratio);
+    std::uniform_int_distribution<size_t> hot_page(0, std::max<size_t>(npages / 5, 1) - 1);
+    std::uniform_int_distribution<size_t> any_page(0, npages - 1);
+    while(!stop.load(std::memory_order_relaxed)) {
+      size_t pid = hot(generator) ? hot_page(generator) : any_page(generator);
+      if(drop(generator)) {
+        store.invalidate(pid);
+        invalidations.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+      size_t res = writer_compressor->compress(buffer.data(), buffer.size(), origin + pid * kPageSize, kPageSize);
+      store.put(pid, buffer.data(), res);
+      writes.fetch_add(1, std::memory_order_relaxed);
+    }
+  });
+
+  std::vector<std::vector<long>> latencies(store_config.readers);
+  std::vector<size_t> misses(store_config.readers), mismatches(store_config.readers);
+  std::vector<std::thread> readers;
+  for(size_t r = 0; r < store_config.readers; r++) {
+    readers.emplace_back([&, r]() {
+      std::unique_ptr<LosslessCompressor> reader_compressor = createCompressor(store_config.algorithm);
+      char* page = (char*) aligned_alloc(kPageSize, kPageSize);
+      std::mt19937_64 generator(100 + r);
+      std::uniform_int_distribution<size_t> any_page(0, npages - 1);
+      Timer timer;
+      while(!stop.load(std::memory_order_relaxed)) {
+        size_t pid = any_page(generator);
+        timer.start();
+        bool found = store.read(pid, [&](const char* data, size_t len) {
+          reader_compressor->decompress(page, kPageSize, (void*) data, len);
+        });
+        long drt = timer.duration_ns();
+        if(!found) {
+          misses[r]++;//invalidated, the next write brings it back
+          continue;
+        }
+        latencies[r].push_back(drt);
+        mismatches[r] += memcmp(page, origin + pid * kPageSize, kPageSize) != 0;
+      }
+      free(page);
+    });
+  }
+
+  std::this_thread::sleep_for(std::chrono::duration<double>(store_config.seconds));
+  stop.store(true);
+  writer.join();
+  for(std::thread& reader : readers) {
+    reader.join();
+  }
+
+  std::vector<long> all;
+  size_t total_misses = 0, total_mismatches = 0;
+  for(size_t r = 0; r < store_config.readers; r++) {
+    all.insert(all.end(), latencies[r].begin(), latencies[r].end());
+    total_misses += misses[r];
+    total_mismatches += mismatches[r];
+  }
+  LogStore::Stats stats = store.stats();
+  double user_bytes = std::max<double>(stats.appended_bytes, 1);
+  std::cout << "[INFO]: writes " << writes.load() << ", invalidations " << invalidations.load()
+            << ", write stalls " << stats.write_stalls << std::endl;
+  std::cout << "[INFO]: reads " << all.size() << " (" << total_misses << " of invalidated pages), read latency "
+            << percentiles(all) << std::endl;
+  std::cout << "[INFO]: compacted segments " << stats.compacted_segments << ", relocated "
+            << double(stats.relocated_bytes) / kMegaByte << " MiB, write amplification "
+            << (user_bytes + stats.relocated_bytes) / user_bytes << ", utilization "
+            << 100.0 * stats.live_bytes / (stats.used_segments * store_config.segment_size) << "% of "
+            << stats.used_segments << " used segments" << std::endl;
+  if(total_mismatches) {
+    std::cout << "[ERROR]: " << total_mismatches << " reads returned wrong data" << std::endl;
+  }
+  free(origin);
+  return total_mismatches ? EXIT_FAILURE : 0;
+}
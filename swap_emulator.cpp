@@ -0,0 +1,277 @@
+#include <fcntl.h>
+#include <linux/userfaultfd.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <thread>
+#include "compress.h"
+#include "benchmark.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+//userfaultfd and madvise work on host pages, whatever page size the benchmark simulates
+static const size_t kSwapPage = sysconf(_SC_PAGESIZE);
+
+namespace {
+
+/**
+ * @brief compressed backing store plus the fault handler state of one emulated swap device:
+ * the region starts out fully swapped, a missing-page fault decompresses the page and maps it
+ * with UFFDIO_COPY, and beyond the resident budget the oldest page is evicted first
+ * (recompressed when dirty, then dropped with MADV_DONTNEED)
+ * */
+class SwapDevice {
+ public:
+  SwapDevice(LosslessCompressor* compressor, char* region, size_t npages, size_t budget)
+      : compressor_(compressor), region_(region), npages_(npages), budget_(budget),
+        slots_(npages), dirty_(npages) {
+    staging_ = (char*) aligned_alloc(kSwapPage, kSwapPage);
+    scratch_ = (char*) aligned_alloc(kSwapPage, 2 * kSwapPage);
+  }
+
+  ~SwapDevice() {
+    free(scratch_);
+    free(staging_);
+  }
+
+  void store(size_t pid, const char* page) {
+    size_t res = compressor_->compress(scratch_, 2 * kSwapPage, (void*) page, kSwapPage);
+    slots_[pid].assign(scratch_, scratch_ + res);
+  }
+
+  void markDirty(size_t pid) { dirty_[pid].store(true, std::memory_order_release); }
+
+  //serve one missing-page fault at addr, called on the handler thread
+  void serve(int uffd, uintptr_t addr) {
+    Timer timer;
+    timer.start();
+    size_t pid = (addr - (uintptr_t) region_) / kSwapPage;
+    if(resident_.size() >= budget_) {
+      evict();
+    }
+    Timer decompress_timer;
+    decompress_timer.start();
+    compressor_->decompress(staging_, kSwapPage, slots_[pid].data(), slots_[pid].size());
+    decompress_ns_.push_back(decompress_timer.duration_ns());
+    struct uffdio_copy copy = {};
+    copy.dst = addr;
+    copy.src = (uintptr_t) staging_;
+    copy.len = kSwapPage;
+    //counted before the copy wakes the faulting thread, which checks the count right after
+    faults_.fetch_add(1, std::memory_order_release);
+    if(ioctl(uffd, UFFDIO_COPY, &copy) != 0 && errno != EEXIST) {
+      std::cerr << "[ERROR]: UFFDIO_COPY failed: " << strerror(errno) << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    resident_.push_back(pid);
+    service_ns_.push_back(timer.duration_ns());
+  }
+
+  size_t faults() const { return faults_.load(std::memory_order_acquire); }
+
+  size_t evictions() const { return evictions_; }
+
+  size_t dirtyEvictions() const { return dirty_evictions_; }
+
+  std::vector<long>& serviceNs() { return service_ns_; }
+
+  std::vector<long>& decompressNs() { return decompress_ns_; }
+
+  size_t storedBytes() const {
+    size_t total = 0;
+    for(const std::vector<char>& slot : slots_) {
+      total += slot.size();
+    }
+    return total;
+  }
+
+ private:
+  //fifo victim, the faulting thread is blocked so the victim is not being accessed
+  void evict() {
+    size_t victim = resident_.front();
+    resident_.pop_front();
+    char* page = region_ + victim * kSwapPage;
+    if(dirty_[victim].exchange(false, std::memory_order_acquire)) {
+      store(victim, page);
+      dirty_evictions_++;
+    }
+    madvise(page, kSwapPage, MADV_DONTNEED);
+    evictions_++;
+  }
+
+  LosslessCompressor* compressor_;
+  char* region_;
+  size_t npages_;
+  size_t budget_;
+  std::vector<std::vector<char>> slots_;
+  std::vector<std::atomic<bool>> dirty_;
+  std::deque<size_t> resident_;
+  char* staging_;
+  char* scratch_;
+  std::atomic<size_t> faults_{0};
+  size_t evictions_ = 0;
+  size_t dirty_evictions_ = 0;
+  std::vector<long> service_ns_;
+  std::vector<long> decompress_ns_;
+};
+
+int openUserfaultfd() {
+  //user-mode-only faults are allowed for unprivileged users when vm.unprivileged_userfaultfd is 0
+  int uffd = (int) syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK | UFFD_USER_MODE_ONLY);
+  if(uffd < 0) {
+    uffd = (int) syscall(SYS_userfaultfd, O_CLOEXEC | O_NONBLOCK);
+  }
+  if(uffd < 0) {
+    std::cerr << "[ERROR]: userfaultfd unavailable: " << strerror(errno) << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  struct uffdio_api api = {};
+  api.api = UFFD_API;
+  if(ioctl(uffd, UFFDIO_API, &api) != 0) {
+    std::cerr << "[ERROR]: UFFDIO_API failed: " << strerror(errno) << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return uffd;
+}
+
+std::string percentiles(std::vector<long>& samples) {
+  if(samples.empty()) {
+    return "none";
+  }
+  std::sort(samples.begin(), samples.end());
+  auto at = [&](double q) { return samples[std::min(samples.size() - 1, size_t(q * samples.size()))] / 1000.0; };
+  char text[160];
+  snprintf(text, sizeof(text), "p50 %.2f p90 %.2f p99 %.2f p99.9 %.2f max %.2f us",
+           at(0.5), at(0.9), at(0.99), at(0.999), samples.back() / 1000.0);
+  return text;
+}
+
+}
+
+int runSwapEmulator(const SwapEmulatorConfig& swap) {
+  std::ifstream fin(swap.path);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << swap.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t size = std::filesystem::file_size(swap.path);
+  if(swap.limit_bytes) {
+    size = std::min(size, swap.limit_bytes);
+  }
+  size_t npages = size / kSwapPage;
+  size = npages * kSwapPage;
+  char* origin = (char*) aligned_alloc(kSwapPage, size);
+  fin.read(origin, size);
+  size_t budget = std::max<size_t>(1, size_t(npages * swap.resident_fraction));
+  size_t naccess = swap.accesses ? swap.accesses : 4 * npages;
+  std::cout << "[INFO]: swap emulator " << swap.path << ", " << npages << " pages, resident budget " << budget
+            << " pages, " << naccess << " random accesses, write ratio " << swap.write_ratio << std::endl;
+
+  bool failed = false;
+  for(const std::string& algorithm : swap.algorithms) {
+    std::unique_ptr<LosslessCompressor> compressor = createCompressor(algorithm);
+    char* region = (char*) mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(region == MAP_FAILED) {
+      std::cerr << "[ERROR]: mmap of " << size << " bytes failed" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+    int uffd = openUserfaultfd();
+    struct uffdio_register reg = {};
+    reg.range.start = (uintptr_t) region;
+    reg.range.len = size;
+    reg.mode = UFFDIO_REGISTER_MODE_MISSING;
+    if(ioctl(uffd, UFFDIO_REGISTER, &reg) != 0) {
+      std::cerr << "[ERROR]: UFFDIO_REGISTER failed: " << strerror(errno) << std::endl;
+      exit(EXIT_FAILURE);
+    }
+
+    //the whole region starts out swapped: every page is compressed into the store up front
+    SwapDevice device(compressor.get(), region, npages, budget);
+    for(size_t pid = 0; pid < npages; pid++) {
+      device.store(pid, origin + pid * kSwapPage);
+    }
+
+    std::atomic<bool> stop{false};
+    std::thread handler([&]() {
+      struct pollfd pfd = {uffd, POLLIN, 0};
+      while(!stop.load(std::memory_order_acquire)) {
+        if(poll(&pfd, 1, 10) <= 0) {
+          continue;
+        }
+        struct uffd_msg msg;
+        if(read(uffd, &msg, sizeof(msg)) != sizeof(msg)) {
+          continue;//EAGAIN: the fault was already served
+        }
+        if(msg.event == UFFD_EVENT_PAGEFAULT) {
+          device.serve(uffd, msg.arg.pagefault.address & ~(uintptr_t) (kSwapPage - 1));
+        }
+      }
+    });
+
+    //application side: random page accesses, a fault is an access during which the handler served one
+    std::mt19937_64 generator(1);
+    std::uniform_int_distribution<size_t> page_dist(0, npages - 1);
+    std::uniform_int_distribution<size_t> offset_dist(0, kSwapPage - 1);
+    std::bernoulli_distribution write_dist(swap.write_ratio);
+    std::vector<long> fault_ns;
+    size_t mismatched = 0;
+    Timer timer;
+    Timer total;
+    total.start();
+    for(size_t i = 0; i < naccess; i++) {
+      size_t pid = page_dist(generator);
+      size_t offset = offset_dist(generator);
+      volatile char* byte = region + pid * kSwapPage + offset;
+      bool write = write_dist(generator);
+      size_t faults = device.faults();
+      timer.start();
+      char value = *byte;
+      if(write) {
+        //rewrite the same value: the page is dirty while its content stays verifiable
+        *byte = value;
+      }
+      long drt = timer.duration_ns();
+      if(write) {
+        device.markDirty(pid);
+      }
+      mismatched += value != origin[pid * kSwapPage + offset];
+      if(device.faults() != faults) {
+        fault_ns.push_back(drt);
+      }
+    }
+    long total_drt = total.duration_us();
+    stop.store(true, std::memory_order_release);
+    handler.join();
+
+    std::cout << "[INFO]: " << algorithm << " store " << double(device.storedBytes()) / kMegaByte << " MiB for "
+              << double(size) / kMegaByte << " MiB, faults " << fault_ns.size() << ", evictions "
+              << device.evictions() << " (" << device.dirtyEvictions() << " dirty), run "
+              << total_drt / 1000 << " ms" << std::endl;
+    std::cout << "[INFO]: " << algorithm << " fault latency " << percentiles(fault_ns) << std::endl;
+    std::cout << "[INFO]: " << algorithm << " handler service " << percentiles(device.serviceNs())
+              << ", decompress " << percentiles(device.decompressNs()) << std::endl;
+    if(mismatched) {
+      std::cout << "[ERROR]: " << algorithm << " returned wrong data on " << mismatched << " accesses" << std::endl;
+      failed = true;
+    }
+
+    close(uffd);
+    munmap(region, size);
+  }
+  free(origin);
+  return failed ? EXIT_FAILURE : 0;
+}
@@ -0,0 +1,330 @@
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include "access_tracker.h"
+#include "compress.h"
+#include "log_store.h"
+#include "benchmark.h"
+#include "util.h"
+
+using namespace FastCompress;
+using namespace util;
+
+//first byte of every stored object: which tier's compressor wrote it
+enum Tier : char {
+  kFastTier = 0,
+  kStrongTier = 1,
+  //worker bookkeeping only, never stored: fast-tier data the strong tier did not shrink
+  kFastKept = 2,
+};
+
+//synthetic reads and writes go to the hot fifth of the pages this often, otherwise to the rest of
+//the first half; the second half is never touched after the initial load and goes cold
+static constexpr double kHotShare = 0.9;
+static constexpr double kHotPages = 0.2;
+static constexpr double kTouchedPages = 0.5;
+//pause between two scans of the recompression worker
+static constexpr std::chrono::milliseconds kScanPeriod(50);
+//cold_ms spans at most this many access tracker epochs, longer ones lengthen the epoch
+static constexpr uint64_t kColdEpochs = 16;
+
+namespace {
+
+double threadCpuSeconds() {
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+std::string percentiles(std::vector<long>& samples) {
+  if(samples.empty()) {
+    return "none";
+  }
+  std::sort(samples.begin(), samples.end());
+  auto at = [&](double q) { return samples[std::min(samples.size() - 1, size_t(q * samples.size()))] / 1000.0; };
+  char text[128];
+  snprintf(text, sizeof(text), "p50 %.2f p99 %.2f max %.2f us (%zu reads)", at(0.5), at(0.99),
+           samples.back() / 1000.0, samples.size());
+  return text;
+}
+
+struct TraceAccess {
+  size_t page;
+  bool write;
+};
+
+//one access per line: page index, optionally followed by w for a write; # starts a comment
+std::vector<TraceAccess> loadTrace(const std::string& path, size_t npages) {
+  std::ifstream fin(path);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  std::vector<TraceAccess> trace;
+  std::string line;
+  while(std::getline(fin, line)) {
+    size_t begin = line.find_first_not_of(" \t");
+    if(begin == std::string::npos || line[begin] == '#') {
+      continue;
+    }
+    size_t end = 0;
+    size_t page = std::stoull(line.substr(begin), &end);
+    bool write = line.find('w', begin + end) != std::string::npos;
+    trace.push_back({page % npages, write});
+  }
+  if(trace.empty()) {
+    std::cerr << "[ERROR]: trace " << path << " has no access" << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  return trace;
+}
+
+//page picker of the synthetic reader and writer, see kHotShare
+class SyntheticAccess {
+ public:
+  explicit SyntheticAccess(size_t npages)
+      : hot_(kHotShare),
+        hot_page_(0, std::max<size_t>(size_t(npages * kHotPages), 1) - 1),
+        warm_page_(0, std::max<size_t>(size_t(npages * kTouchedPages), 1) - 1) {}
+
+  size_t operator()(std::mt19937_64& generator) {
+    return hot_(generator) ? hot_page_(generator) : warm_page_(generator);
+  }
+
+ private:
+  std::bernoulli_distribution hot_;
+  std::uniform_int_distribution<size_t> hot_page_;
+  std::uniform_int_distribution<size_t> warm_page_;
+};
+
+//the two compressors of one thread, indexed by tier
+struct TierCompressors {
+  std::unique_ptr<LosslessCompressor> fast;
+  std::unique_ptr<LosslessCompressor> strong;
+
+  explicit TierCompressors(const TieredConfig& tiered)
+      : fast(createCompressor(tiered.fast_algorithm)),
+        strong(std::make_unique<SameFillFilter>(std::make_unique<ZSTD>(tiered.strong_level))) {}
+
+  LosslessCompressor* of(char tier) { return tier == kStrongTier ? strong.get() : fast.get(); }
+};
+
+}
+
+int runTieredStore(const TieredConfig& tiered) {
+  std::ifstream fin(tiered.path);
+  if(!fin.good()) {
+    std::cerr << "[ERROR]: can't open " << tiered.path << std::endl;
+    exit(EXIT_FAILURE);
+  }
+  size_t size = std::filesystem::file_size(tiered.path);
+  if(tiered.limit_bytes) {
+    size = std::min(size, tiered.limit_bytes);
+  }
+  size_t npages = size / kPageSize;
+  size = npages * kPageSize;
+  char* origin = (char*) aligned_alloc(kPageSize, size);
+  fin.read(origin, size);
+
+  //every page starts in the fast tier
+  TierCompressors main_compressors(tiered);
+  std::vector<char> scratch(2 * kPageSize + 1);
+  std::vector<std::vector<char>> initial(npages);
+  size_t footprint = 0;
+  for(size_t pid = 0; pid < npages; pid++) {
+    scratch[0] = kFastTier;
+    size_t res = 1 + main_compressors.fast->compress(scratch.data() + 1, scratch.size() - 1,
+                                                     origin + pid * kPageSize, kPageSize);
+    initial[pid].assign(scratch.data(), scratch.data() + res);
+    footprint += 16 + (res + 7) / 8 * 8;
+  }
+  size_t segment_size = 128 * 1024;
+  LogStore store(npages, segment_size, size_t(footprint * 1.25 / segment_size) + 8);
+  for(size_t pid = 0; pid < npages; pid++) {
+    store.put(pid, initial[pid].data(), initial[pid].size());
+  }
+  initial.clear();
+
+  auto start = std::chrono::steady_clock::now();
+  auto now_ms = [&]() {
+    return (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  };
+  std::vector<TraceAccess> trace;
+  if(!tiered.trace.empty()) {
+    trace = loadTrace(tiered.trace, npages);
+  }
+  AccessTracker tracker(npages);
+  AccessTracker::Thresholds thresholds;
+  //epochs are timed by the clock, whatever a scan takes, and are short enough to resolve cold_ms
+  uint64_t epoch_ms = std::max<uint64_t>((tiered.cold_ms + kColdEpochs - 1) / kColdEpochs, kScanPeriod.count());
+  thresholds.cold_age = std::max<uint64_t>((tiered.cold_ms + epoch_ms - 1) / epoch_ms, 1);
+  thresholds.frozen_age = 4 * thresholds.cold_age;
+  std::vector<std::atomic<char>> tier(npages);
+  for(size_t pid = 0; pid < npages; pid++) {
+    tier[pid].store(kFastTier, std::memory_order_relaxed);
+  }
+  size_t live_before = store.stats().live_bytes;
+  std::cout << "[INFO]: tiered store " << tiered.path << ", " << npages << " pages, fast tier " << tiered.fast_algorithm
+            << ", strong tier zstd level " << tiered.strong_level << ", cold after " << tiered.cold_ms << " ms ("
+            << int(thresholds.cold_age) << " epochs of " << epoch_ms << " ms), "
+            << tiered.seconds << " s, "
+            << (trace.empty() ? "synthetic accesses" : std::to_string(trace.size()) + " trace accesses") << std::endl;
+
+  std::atomic<bool> stop{false};
+  //recompression worker: pages the tracker calls cold move to the strong tier if that shrinks them.
+  //Only Cold drives a decision here: Hot (keep raw) and Frozen (write back) are classified and
+  //counted, this mode has no raw tier or backing device to move them to
+  size_t recompressed = 0, rejected = 0, raced = 0;
+  double worker_cpu = 0;
+  size_t saved_bytes = 0;
+  std::thread worker([&]() {
+    TierCompressors compressors(tiered);
+    char* page = (char*) aligned_alloc(kPageSize, kPageSize);
+    std::vector<char> out(2 * kPageSize + 1);
+    double cpu_start = threadCpuSeconds();
+    uint64_t epochs = 0;
+    while(!stop.load(std::memory_order_relaxed)) {
+      for(uint64_t due = now_ms() / epoch_ms; epochs < due; epochs++) {
+        tracker.tick();
+      }
+      for(size_t pid = 0; pid < npages && !stop.load(std::memory_order_relaxed); pid++) {
+        if(tier[pid].load(std::memory_order_relaxed) != kFastTier
+           || tracker.classify(pid, thresholds) < Temperature::Cold) {
+          continue;
+        }
+        uint64_t version = 0;
+        size_t old_len = 0;
+        bool found = store.read(pid, [&](const char* data, size_t len) {
+          old_len = len;
+          compressors.of(data[0])->decompress(page, kPageSize, (void*) (data + 1), len - 1);
+        }, &version);
+        if(!found) {
+          continue;
+        }
+        out[0] = kStrongTier;
+        size_t res = 1 + compressors.strong->compress(out.data() + 1, out.size() - 1, page, kPageSize);
+        if(res >= old_len) {
+          //incompressible beyond the fast tier: keep it, and do not retry it every scan
+          tier[pid].store(kFastKept, std::memory_order_relaxed);
+          rejected++;
+          continue;
+        }
+        if(store.replace(pid, version, out.data(), res)) {
+          tier[pid].store(kStrongTier, std::memory_order_relaxed);
+          recompressed++;
+          saved_bytes += old_len - res;
+        } else {
+          raced++;//written or relocated since the read, the next scan retries
+        }
+      }
+      std::this_thread::sleep_for(kScanPeriod);
+    }
+    worker_cpu = threadCpuSeconds() - cpu_start;
+    free(page);
+  });
+
+  //overwrites land in the fast tier again
+  auto writePage = [&](TierCompressors& compressors, std::vector<char>& out, size_t pid) {
+    out[0] = kFastTier;
+    size_t res = 1 + compressors.fast->compress(out.data() + 1, out.size() - 1, origin + pid * kPageSize, kPageSize);
+    //mark fast before the put, so the worker never sees the new version as already strong
+    tier[pid].store(kFastTier, std::memory_order_relaxed);
+    tracker.record(pid);
+    store.put(pid, out.data(), res);
+  };
+
+  //synthetic writer, a trace carries its own writes
+  std::thread writer;
+  if(trace.empty()) {
+    writer = std::thread([&]() {
+      TierCompressors compressors(tiered);
+      std::vector<char> out(2 * kPageSize + 1);
+      std::mt19937_64 generator(1);
+      SyntheticAccess access(npages);
+      while(!stop.load(std::memory_order_relaxed)) {
+        writePage(compressors, out, access(generator));
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+      }
+    });
+  }
+
+  //reader, or trace replay looping over the trace: fault latency by the tier that served it
+  std::vector<long> fast_ns, strong_ns;
+  size_t mismatches = 0;
+  size_t replayed = 0;
+  {
+    TierCompressors compressors(tiered);
+    std::vector<char> out(2 * kPageSize + 1);
+    char* page = (char*) aligned_alloc(kPageSize, kPageSize);
+    std::mt19937_64 generator(2);
+    SyntheticAccess synthetic(npages);
+    Timer timer;
+    while(now_ms() < tiered.seconds * 1000) {
+      size_t pid;
+      if(trace.empty()) {
+        pid = synthetic(generator);
+      } else {
+        const TraceAccess& access = trace[replayed++ % trace.size()];
+        pid = access.page;
+        if(access.write) {
+          writePage(compressors, out, pid);
+          continue;
+        }
+      }
+      char served = kFastTier;
+      timer.start();
+      store.read(pid, [&](const char* data, size_t len) {
+        served = data[0];
+        compressors.of(data[0])->decompress(page, kPageSize, (void*) (data + 1), len - 1);
+      });
+      long drt = timer.duration_ns();
+      tracker.record(pid);
+      (served == kStrongTier ? strong_ns : fast_ns).push_back(drt);
+      mismatches += memcmp(page, origin + pid * kPageSize, kPageSize) != 0;
+    }
+    free(page);
+  }
+  stop.store(true);
+  if(writer.joinable()) {
+    writer.join();
+  }
+  worker.join();
+
+  size_t strong_pages = 0;
+  size_t temperatures[4] = {0, 0, 0, 0};
+  for(size_t pid = 0; pid < npages; pid++) {
+    //from the stored tag byte, the tier array only steers the worker
+    store.read(pid, [&](const char* data, size_t) { strong_pages += data[0] == kStrongTier; });
+    temperatures[(int) tracker.classify(pid, thresholds)]++;
+  }
+  size_t live_after = store.stats().live_bytes;
+  std::cout << "[INFO]: recompressed " << recompressed << " cold pages (" << rejected << " not smaller, " << raced
+            << " raced with writes), " << strong_pages << " pages (" << 100.0 * strong_pages / npages
+            << "%) in the strong tier at the end" << std::endl;
+  std::cout << "[INFO]: worker cpu " << worker_cpu << " s, recompression saved " << double(saved_bytes) / kMegaByte
+            << " MiB (" << double(saved_bytes) / kMegaByte / std::max(worker_cpu, 1e-9)
+            << " MiB per cpu second), store live " << double(live_before) / kMegaByte << " -> "
+            << double(live_after) / kMegaByte << " MiB" << std::endl;
+  std::cout << "[INFO]: access tracker: " << temperatures[0] << " hot (keep raw), " << temperatures[1]
+            << " warm (fast), " << temperatures[2] << " cold (strong), " << temperatures[3] << " frozen (write back), only cold is acted on";
+  if(!trace.empty()) {
+    std::cout << ", " << replayed << " trace accesses replayed";
+  }
+  std::cout << std::endl;
+  std::cout << "[INFO]: read latency fast tier " << percentiles(fast_ns) << std::endl;
+  std::cout << "[INFO]: read latency strong tier " << percentiles(strong_ns) << std::endl;
+  if(mismatches) {
+    std::cout << "[ERROR]: " << mismatches << " reads returned wrong data" << std::endl;
+  }
+  free(origin);
+  return mismatches ? EXIT_FAILURE : 0;
+}
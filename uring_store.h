@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) 2025, Chen Yuan <yuan.chen@whu.edu.cn>
+ *
+ * All rights reserved. No warranty, explicit or implicit, provided.
+ */
+
+#ifndef FASTCOMPRESS_URING_STORE_H
+#define FASTCOMPRESS_URING_STORE_H
+
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include "async_compress.h"
+
+namespace FastCompress {
+
+/**
+ * @brief backing file of fixed-size slots (compressed pages written back) driven by io_uring.
+ *
+ * write()/read() queue one request and return at once; done(res) runs on the store's completion
+ * thread with the byte count or -errno. At most depth requests are in flight, further submitters
+ * wait, so done callbacks that submit again must keep the total under depth. Talks to the kernel
+ * through the raw syscalls, liburing is not required.
+ * */
+class UringBackingStore {
+ public:
+  using Done = std::function<void(int)>;
+
+  /**
+   * @param path backing file, created or truncated, removed again by the destructor
+   * @param slot_size bytes per slot, slot i starts at offset i * slot_size
+   * @param depth submission queue entries, the in-flight request limit
+   * */
+  UringBackingStore(const std::string& path, size_t slot_size, unsigned depth)
+      : path_(path), slot_size_(slot_size) {
+    file_ = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(file_ < 0) {
+      throw std::runtime_error("can't open " + path + ": " + strerror(errno));
+    }
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_ = syscall(__NR_io_uring_setup, depth, &params);
+    if(ring_ < 0) {
+      int error = errno;
+      close(file_);
+      unlink(path.c_str());
+      throw std::runtime_error(std::string("io_uring_setup: ") + strerror(error));
+    }
+    depth_ = params.sq_entries;
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if(params.features & IORING_FEAT_SINGLE_MMAP) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQ_RING);
+    cq_ring_ = params.features & IORING_FEAT_SINGLE_MMAP
+                   ? sq_ring_
+                   : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_,
+                          IORING_OFF_CQ_RING);
+    sqes_ = (io_uring_sqe*) mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                                 MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQES);
+    if(sq_ring_ == MAP_FAILED || cq_ring_ == MAP_FAILED || sqes_ == MAP_FAILED) {
+      //the destructor does not run for a throwing constructor, release what was set up so far
+      int error = errno;
+      if(sqes_ != MAP_FAILED) {
+        munmap(sqes_, depth_ * sizeof(io_uring_sqe));
+      }
+      if(cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+        munmap(cq_ring_, cq_ring_size_);
+      }
+      if(sq_ring_ != MAP_FAILED) {
+        munmap(sq_ring_, sq_ring_size_);
+      }
+      close(ring_);
+      close(file_);
+      unlink(path.c_str());
+      throw std::runtime_error(std::string("io_uring mmap: ") + strerror(error));
+    }
+    char* sq = (char*) sq_ring_;
+    sq_tail_ = (unsigned*) (sq + params.sq_off.tail);
+    sq_mask_ = *(unsigned*) (sq + params.sq_off.ring_mask);
+    sq_array_ = (unsigned*) (sq + params.sq_off.array);
+    char* cq = (char*) cq_ring_;
+    cq_head_ = (unsigned*) (cq + params.cq_off.head);
+    cq_tail_ = (unsigned*) (cq + params.cq_off.tail);
+    cq_mask_ = *(unsigned*) (cq + params.cq_off.ring_mask);
+    cqes_ = (io_uring_cqe*) (cq + params.cq_off.cqes);
+    completer_ = std::thread([this]() { completeLoop(); });
+  }
+
+  ~UringBackingStore() {
+    //a nop without callback tells the completion thread to leave; IOSQE_IO_DRAIN holds it back
+    //until every earlier request completed, so no done callback is skipped or leaked
+    submit(IORING_OP_NOP, 0, nullptr, 0, nullptr, IOSQE_IO_DRAIN);
+    completer_.join();
+    munmap(sqes_, depth_ * sizeof(io_uring_sqe));
+    if(cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    munmap(sq_ring_, sq_ring_size_);
+    close(ring_);
+    close(file_);
+    unlink(path_.c_str());
+  }
+
+  UringBackingStore(const UringBackingStore&) = delete;
+
+  UringBackingStore& operator=(const UringBackingStore&) = delete;
+
+  //the caller keeps data alive until done runs
+  void write(size_t slot, const void* data, size_t len, Done done) {
+    submit(IORING_OP_WRITE, slot, const_cast<void*>(data), std::min(len, slot_size_), new Done(std::move(done)));
+  }
+
+  void read(size_t slot, void* data, size_t len, Done done) {
+    submit(IORING_OP_READ, slot, data, std::min(len, slot_size_), new Done(std::move(done)));
+  }
+
+  size_t slotSize() const { return slot_size_; }
+
+ private:
+  void submit(uint8_t opcode, size_t slot, void* data, size_t len, Done* done, uint8_t flags = 0) {
+    std::unique_lock<std::mutex> lock(submit_mutex_);
+    submit_cv_.wait(lock, [this]() { return inflight_ < depth_; });
+    inflight_++;
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->flags = flags;
+    sqe->fd = file_;
+    sqe->addr = (uint64_t) data;
+    sqe->len = len;
+    sqe->off = slot * slot_size_;
+    sqe->user_data = (uint64_t) done;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    while(syscall(__NR_io_uring_enter, ring_, 1, 0, 0, nullptr, 0) < 0 && errno == EINTR) {
+    }
+  }
+
+  void completeLoop() {
+    while(true) {
+      unsigned head = *cq_head_;
+      if(head == __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        syscall(__NR_io_uring_enter, ring_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        continue;
+      }
+      io_uring_cqe cqe = cqes_[head & cq_mask_];
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      {
+        std::lock_guard<std::mutex> lock(submit_mutex_);
+        inflight_--;
+      }
+      submit_cv_.notify_one();
+      Done* done = (Done*) cqe.user_data;
+      if(done == nullptr) {
+        return;
+      }
+      (*done)(cqe.res);
+      delete done;
+    }
+  }
+
+  std::string path_;
+  size_t slot_size_;
+  int file_ = -1;
+  int ring_ = -1;
+  unsigned depth_ = 0;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  void* sq_ring_ = nullptr;
+  void* cq_ring_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned sq_mask_ = 0;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned cq_mask_ = 0;
+  io_uring_cqe* cqes_ = nullptr;
+  std::mutex submit_mutex_;
+  std::condition_variable submit_cv_;
+  unsigned inflight_ = 0;
+  std::thread completer_;
+};
+
+#ifdef FASTCOMPRESS_COROUTINES
+
+//co_await writeBackAsync(...) yields the bytes written or -errno, resuming on the completion thread
+inline CallbackAwaitable<int> writeBackAsync(UringBackingStore& store, size_t slot, const void* data, size_t len) {
+  return CallbackAwaitable<int>([=, &store](UringBackingStore::Done done) { store.write(slot, data, len, std::move(done)); });
+}
+
+//co_await readBackAsync(...) yields the bytes read or -errno, resuming on the completion thread
+inline CallbackAwaitable<int> readBackAsync(UringBackingStore& store, size_t slot, void* data, size_t len) {
+  return CallbackAwaitable<int>([=, &store](UringBackingStore::Done done) { store.read(slot, data, len, std::move(done)); });
+}
+
+#endif
+
+}
+
+#endif //FASTCOMPRESS_URING_STORE_H
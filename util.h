@@ -21,6 +21,12 @@ namespace util {
       auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
       return duration.count();
     }
+
+    long duration_ns() {
+      auto end_time = std::chrono::high_resolution_clock::now();
+      auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time);
+      return duration.count();
+    }
   };
 
   class PinningMap {